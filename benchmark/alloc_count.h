@@ -0,0 +1,72 @@
+/// @file alloc_count.h
+/// @brief 替换全局 operator new/delete，统计进程内的分配次数
+/// @details
+/// 基准测试和零分配测试共用。替换函数只能定义一次，每个程序只在一个翻译单元中包含这个文件。
+/// 所有标量、数组和带大小的形式一起替换，保证 new 与 delete 成对。
+///
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace bench {
+
+namespace detail {
+
+inline std::atomic<std::uint64_t> &allocations()
+{
+    static std::atomic<std::uint64_t> count{0};
+    return count;
+}
+
+inline void *counted_alloc(std::size_t size)
+{
+    allocations().fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+}  // namespace detail
+
+/// @brief 进程内 operator new 被调用的总次数
+std::uint64_t allocation_count()
+{
+    return detail::allocations().load(std::memory_order_relaxed);
+}
+
+}  // namespace bench
+
+void *operator new(std::size_t size)
+{
+    return bench::detail::counted_alloc(size);
+}
+
+void *operator new[](std::size_t size)
+{
+    return bench::detail::counted_alloc(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t /*size*/) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p, std::size_t /*size*/) noexcept
+{
+    std::free(p);
+}
@@ -0,0 +1,99 @@
+/// @file batch.cpp
+/// @brief 批量解析的吞吐量随线程数的变化
+/// @details
+/// 基线是用 std::getline 逐行读取后在一个线程上调用 parse(const std::string &)。
+/// batch/* 用例的线程数包括调用线程，超过机器的核数后吞吐量不再增加。
+#include <cmdline/batch.h>
+#include <cmdline/parallel.h>
+
+#include <atomic>
+#include <sstream>
+#include <string>
+
+#include "bench.h"
+
+namespace {
+
+void spec(cmdline::parser &p)
+{
+    p.add<std::string>("host", 0, "host name", true, "");
+    p.add<int>("port", 'p', "port number", false, 80, cmdline::range(1, 65535));
+    p.add<std::string>("type", 't', "protocol type", false, "http",
+                       cmdline::oneof<std::string>("http", "https", "ssh", "ftp"));
+    p.add<double>("ratio", 'r', "ratio", false, 0.5);
+    p.add("gzip", 'g', "gzip when transfer");
+    p.add("verbose", 'v', "verbose");
+}
+
+const int line_count = 100000;
+
+/// @brief 每行一条命令，其中约1%解析失败
+const std::string &command_lines()
+{
+    static const std::string text = [] {
+        std::string s;
+        for (int i = 0; i < line_count; i++) {
+            if (i % 100 == 0) {
+                s += "prog --port=0 file\n";
+            } else {
+                s += "prog --host=host" + std::to_string(i) + " -p " + std::to_string(i % 60000 + 1) +
+                     " --type https -r 0.25 -gv file" + std::to_string(i) + ".txt\n";
+            }
+        }
+        return s;
+    }();
+    return text;
+}
+
+void getline_serial(bench::state &st)
+{
+    cmdline::parser p;
+    spec(p);
+    std::string line;
+    st.set_items_per_iteration(line_count);
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        std::istringstream in(command_lines());
+        std::size_t ok = 0;
+        while (std::getline(in, line)) {
+            ok += p.parse(line) ? 1 : 0;
+        }
+        bench::do_not_optimize(ok);
+    }
+    st.stop();
+}
+BENCH_CASE("batch/getline_serial", getline_serial);
+
+template <int Threads, cmdline::delivery Order, bool Oversubscribe = false>
+void parse_many(bench::state &st)
+{
+    cmdline::thread_pool pool(Threads - 1);
+    cmdline::batch b(spec, &pool, Threads, Oversubscribe);
+    std::atomic<std::size_t> ok{0};
+    cmdline::batch::line_fn const count = [&](std::size_t, const cmdline::parser &, bool good) {
+        if (good) {
+            ok.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+    const std::string &text = command_lines();
+    st.set_items_per_iteration(line_count);
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        bench::do_not_optimize(b.parse_many(text.data(), text.size(), count, Order));
+    }
+    st.stop();
+    bench::do_not_optimize(ok.load());
+}
+BENCH_CASE("batch/ordered_1", (parse_many<1, cmdline::delivery::ordered>));
+BENCH_CASE("batch/ordered_2", (parse_many<2, cmdline::delivery::ordered>));
+BENCH_CASE("batch/ordered_4", (parse_many<4, cmdline::delivery::ordered>));
+BENCH_CASE("batch/ordered_8", (parse_many<8, cmdline::delivery::ordered>));
+BENCH_CASE("batch/unordered_1", (parse_many<1, cmdline::delivery::unordered>));
+BENCH_CASE("batch/unordered_2", (parse_many<2, cmdline::delivery::unordered>));
+BENCH_CASE("batch/unordered_4", (parse_many<4, cmdline::delivery::unordered>));
+BENCH_CASE("batch/unordered_8", (parse_many<8, cmdline::delivery::unordered>));
+// 不按核数限制工作槽数，核数少于8时与上面的 *_8 对比超额订阅的代价
+BENCH_CASE("batch/ordered_8_oversubscribed", (parse_many<8, cmdline::delivery::ordered, true>));
+BENCH_CASE("batch/unordered_8_oversubscribed", (parse_many<8, cmdline::delivery::unordered, true>));
+
+}  // namespace
@@ -0,0 +1,98 @@
+/// @file bench.h
+/// @brief 不依赖第三方库的基准测试框架
+/// @details
+/// 每个用例接收一个 bench::state，自行准备数据后在 start()/stop() 之间执行 iterations() 次被测操作。
+/// 框架负责校准迭代次数、重复测量取中位数，并统计每次操作的内存分配次数。
+///
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+/// @brief 进程内 operator new 被调用的总次数，定义在 alloc_count.h，由 main.cpp 包含
+std::uint64_t allocation_count();
+
+/// @brief 单次测量的状态
+class state
+{
+  public:
+    explicit state(std::uint64_t iterations) : iters(iterations) {}
+
+    std::uint64_t iterations() const { return iters; }
+
+    /// @brief 开始计时，之前的准备工作不计入结果
+    /// @details 可以多次 start()/stop()，两次之间的准备工作不计入，耗时和分配次数累加
+    void start()
+    {
+        allocs_begin = allocation_count();
+        begin = std::chrono::steady_clock::now();
+    }
+
+    /// @brief 结束计时
+    void stop()
+    {
+        elapsed += std::chrono::steady_clock::now() - begin;
+        allocs += allocation_count() - allocs_begin;
+    }
+
+    double elapsed_ns() const { return std::chrono::duration<double, std::nano>(elapsed).count(); }
+
+    std::uint64_t allocations() const { return allocs; }
+
+    /// @brief 每次迭代处理的条目数，用于计算吞吐量(例如每次解析多行)
+    void set_items_per_iteration(double n) { items = n; }
+
+    double items_per_iteration() const { return items; }
+
+  private:
+    std::uint64_t iters;
+    std::uint64_t allocs{0};
+    std::uint64_t allocs_begin{0};
+    double items{1};
+    std::chrono::steady_clock::time_point begin{};
+    std::chrono::steady_clock::duration elapsed{0};
+};
+
+typedef void (*case_fn)(state &);
+
+struct case_info
+{
+    std::string name;
+    case_fn fn;
+};
+
+inline std::vector<case_info> &registry()
+{
+    static std::vector<case_info> cases;
+    return cases;
+}
+
+/// @brief 静态注册用例
+struct registrar
+{
+    registrar(const char *name, case_fn fn) { registry().push_back(case_info{name, fn}); }
+};
+
+/// @brief 阻止编译器把结果优化掉
+template <class T>
+inline void do_not_optimize(const T &value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void *sink;
+    sink = &value;
+#endif
+}
+
+}  // namespace bench
+
+#define BENCH_CONCAT_IMPL(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_IMPL(a, b)
+
+/// @brief 注册一个基准测试用例
+#define BENCH_CASE(name, fn) static const bench::registrar BENCH_CONCAT(bench_registrar_, __LINE__)(name, fn)
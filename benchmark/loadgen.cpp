@@ -0,0 +1,304 @@
+/// @file loadgen.cpp
+/// @brief cmdline::server 的压力测试客户端
+/// @details
+/// 打开多个连接，每个连接保持固定数量的未完成命令，按回复的行统计每条命令的延迟，
+/// 最后报告每秒命令数和延迟分位数。不指定地址时在本进程中启动一个服务器。
+/// 要求服务器对每条命令回复且只回复一行。
+#include <cmdline/server.h>
+#include <cmdline/usage.h>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::uint64_t now_ns()
+{
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+}
+
+/// @brief 一个客户端连接
+struct connection
+{
+    int fd{-1};
+    /// @brief 还要发送的命令数
+    std::uint64_t remaining{0};
+    /// @brief 未完成命令的发送时间，按发送顺序
+    std::vector<std::uint64_t> pending{};
+    std::size_t pending_head{0};
+    std::string out{};
+    std::size_t sent{0};
+    /// @brief 当前在 epoll 中关注的事件
+    std::uint32_t events{0};
+};
+
+int connect_to(const std::string &unix_path, int port)
+{
+    int fd = -1;
+    if (!unix_path.empty()) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, unix_path.c_str(), sizeof(addr.sun_path) - 1);
+        fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && ::connect(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    } else {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<std::uint16_t>(port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && ::connect(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0) {
+            ::close(fd);
+            fd = -1;
+        }
+        int const on = 1;
+        if (fd >= 0) {
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        }
+    }
+    if (fd >= 0) {
+        int const flags = ::fcntl(fd, F_GETFL, 0);
+        ::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    }
+    return fd;
+}
+
+/// @brief 向连接追加一条命令
+void enqueue(connection &c, const std::string &command)
+{
+    c.out += command;
+    c.pending.push_back(now_ns());
+    c.remaining--;
+}
+
+bool flush(connection &c)
+{
+    while (c.sent < c.out.size()) {
+        ssize_t const n = ::send(c.fd, c.out.data() + c.sent, c.out.size() - c.sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            c.sent += static_cast<std::size_t>(n);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            return false;
+        }
+    }
+    if (c.sent == c.out.size()) {
+        c.out.clear();
+        c.sent = 0;
+    }
+    return true;
+}
+
+/// @brief 还有没发送完的数据时关注可写
+void update(int epfd, connection &c, std::size_t i)
+{
+    std::uint32_t const events = c.sent < c.out.size() ? EPOLLIN | EPOLLOUT : EPOLLIN;
+    if (events != c.events) {
+        epoll_event ev{};
+        ev.events = events;
+        ev.data.u64 = i;
+        ::epoll_ctl(epfd, c.events == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, c.fd, &ev);
+        c.events = events;
+    }
+}
+
+double percentile(const std::vector<std::uint64_t> &sorted, double q)
+{
+    if (sorted.empty()) {
+        return 0;
+    }
+    std::size_t const i = static_cast<std::size_t>(q * static_cast<double>(sorted.size() - 1) + 0.5);
+    return static_cast<double>(sorted[i]) / 1000.0;
+}
+
+/// @brief 关闭所有连接
+bool finish(int epfd, std::vector<connection> &conns, bool ok)
+{
+    for (auto &c : conns) {
+        if (c.fd >= 0) {
+            ::close(c.fd);
+            c.fd = -1;
+        }
+    }
+    ::close(epfd);
+    return ok;
+}
+
+/// @brief 建立连接并发送全部命令，记录每条命令的延迟
+bool drive(const std::string &unix_path, int port, std::size_t connections, std::uint64_t total, std::size_t depth,
+           const std::string &command, std::vector<std::uint64_t> &latencies, std::uint64_t &elapsed)
+{
+    int const epfd = ::epoll_create1(EPOLL_CLOEXEC);
+    std::vector<connection> conns(connections);
+    for (std::size_t i = 0; i < conns.size(); i++) {
+        connection &c = conns[i];
+        c.fd = connect_to(unix_path, port);
+        if (c.fd < 0) {
+            std::fprintf(stderr, "connect failed: %s\n", std::strerror(errno));
+            return finish(epfd, conns, false);
+        }
+        c.remaining = total / conns.size() + (i < total % conns.size() ? 1 : 0);
+        c.pending.reserve(static_cast<std::size_t>(c.remaining));
+    }
+
+    latencies.reserve(static_cast<std::size_t>(total));
+    std::uint64_t const begin = now_ns();
+
+    std::size_t open = conns.size();
+    for (std::size_t i = 0; i < conns.size(); i++) {
+        connection &c = conns[i];
+        if (c.remaining == 0) {
+            ::close(c.fd);
+            c.fd = -1;
+            open--;
+            continue;
+        }
+        while (c.pending.size() - c.pending_head < depth && c.remaining > 0) {
+            enqueue(c, command);
+        }
+        flush(c);
+        update(epfd, c, i);
+    }
+
+    char buf[64 * 1024];
+    epoll_event events[256];
+    while (open > 0) {
+        int const n = ::epoll_wait(epfd, events, 256, 1000);
+        if (n == 0) {
+            std::fprintf(stderr, "timed out waiting for replies\n");
+            return finish(epfd, conns, false);
+        }
+        for (int e = 0; e < n; e++) {
+            std::size_t const i = static_cast<std::size_t>(events[e].data.u64);
+            connection &c = conns[i];
+            if (c.fd < 0) {
+                continue;
+            }
+            bool failed = false;
+            while (true) {
+                ssize_t const got = ::read(c.fd, buf, sizeof(buf));
+                if (got <= 0) {
+                    failed = got == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR);
+                    break;
+                }
+                std::uint64_t const t = now_ns();
+                for (const char *p = buf; (p = static_cast<const char *>(
+                                               std::memchr(p, '\n', static_cast<std::size_t>(buf + got - p)))) != nullptr;
+                     p++) {
+                    if (c.pending_head < c.pending.size()) {
+                        latencies.push_back(t - c.pending[c.pending_head++]);
+                    }
+                }
+            }
+            while (!failed && c.remaining > 0 && c.pending.size() - c.pending_head < depth) {
+                enqueue(c, command);
+            }
+            if (failed || !flush(c)) {
+                std::fprintf(stderr, "connection closed by server\n");
+                return finish(epfd, conns, false);
+            }
+            if (c.remaining == 0 && c.pending_head == c.pending.size()) {
+                ::close(c.fd);
+                c.fd = -1;
+                open--;
+            } else {
+                update(epfd, c, i);
+            }
+        }
+    }
+    elapsed = now_ns() - begin;
+    return finish(epfd, conns, true);
+}
+
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+    cmdline::parser a;
+    a.add<std::string>("unix", 'u', "unix socket path of a running server", false, "");
+    a.add<int>("port", 'p', "tcp port of a running server on 127.0.0.1 (0: start one in this process)", false, 0,
+               cmdline::range(0, 65535));
+    a.add<int>("connections", 'c', "concurrent sessions", false, 64, cmdline::range(1, 100000));
+    a.add<int>("commands", 'n', "total commands", false, 200000, cmdline::range(1, 1000000000));
+    a.add<int>("depth", 'd', "outstanding commands per session", false, 1, cmdline::range(1, 1024));
+    a.add<std::string>("command", 0, "command line to send", false, "--host=github.com -p 8080 -t https file");
+    a.parse_check(argc, argv);
+
+    std::string const unix_path = a.get<std::string>("unix");
+    int port = a.get<int>("port");
+    int const connections = a.get<int>("connections");
+    std::uint64_t const total = static_cast<std::uint64_t>(a.get<int>("commands"));
+    std::size_t const depth = static_cast<std::size_t>(a.get<int>("depth"));
+    std::string const command = a.get<std::string>("command") + "\n";
+
+    // 本进程中的服务器：与 examples/server 相同的选项，每条命令回复一行
+    std::unique_ptr<cmdline::server> embedded;
+    std::thread loop;
+    if (unix_path.empty() && port == 0) {
+        embedded.reset(new cmdline::server(
+            [](cmdline::parser &p) {
+                p.add<std::string>("host", 0, "host name", true, "");
+                p.add<int>("port", 'p', "port number", false, 80, cmdline::range(1, 65535));
+                p.add<std::string>("type", 't', "protocol type", false, "http",
+                                   cmdline::oneof<std::string>("http", "https", "ssh", "ftp"));
+            },
+            [](cmdline::server::session &s, const cmdline::parser &p, bool ok) {
+                if (!ok) {
+                    s.write(p.error() + "\n");
+                    return;
+                }
+                s.write(p.get<std::string>("host") + ":" + std::to_string(p.get<int>("port")) + "\n");
+            }));
+        if (!embedded->listen_tcp("127.0.0.1", 0)) {
+            std::fprintf(stderr, "listen failed: %s\n", std::strerror(errno));
+            return 1;
+        }
+        port = embedded->port();
+        loop = std::thread([&] { embedded->run(); });
+    }
+
+    std::vector<std::uint64_t> latencies;
+    std::uint64_t elapsed = 0;
+    bool const ok = drive(unix_path, port, static_cast<std::size_t>(connections), total, depth, command, latencies,
+                          elapsed);
+
+    if (embedded) {
+        embedded->stop();
+        loop.join();
+    }
+    if (!ok) {
+        return 1;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    double const seconds = static_cast<double>(elapsed) / 1e9;
+    std::printf("%-12s %12s %12s %10s %10s %10s %10s\n", "connections", "commands", "cmds/s", "p50 us", "p99 us",
+                "p999 us", "max us");
+    std::printf("%-12d %12llu %12.0f %10.1f %10.1f %10.1f %10.1f\n", connections,
+                static_cast<unsigned long long>(latencies.size()), static_cast<double>(latencies.size()) / seconds,
+                percentile(latencies, 0.5), percentile(latencies, 0.99), percentile(latencies, 0.999),
+                percentile(latencies, 1.0));
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include <cmdline/core.h>
+#include <cmdline/usage.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "alloc_count.h"
+#include "bench.h"
+
+namespace {
+
+struct result
+{
+    std::string name;
+    std::uint64_t iterations;
+    double ns_per_op;
+    double items_per_sec;
+    double allocs_per_op;
+};
+
+/// @brief 校准迭代次数，然后重复测量取中位数
+result run(const bench::case_info &c, double min_time_ns, int repetitions)
+{
+    std::uint64_t iters = 1;
+    while (true) {
+        bench::state st(iters);
+        c.fn(st);
+        double const ns = st.elapsed_ns();
+        if (ns >= min_time_ns || iters >= (1ULL << 40)) {
+            break;
+        }
+        // 估算达到最短时间需要的次数，至少翻倍，最多放大十倍
+        double scale = ns > 0 ? min_time_ns * 1.2 / ns : 10.0;
+        scale = std::min(10.0, std::max(2.0, scale));
+        iters = static_cast<std::uint64_t>(static_cast<double>(iters) * scale);
+    }
+
+    std::vector<result> samples;
+    for (int i = 0; i < repetitions; i++) {
+        bench::state st(iters);
+        c.fn(st);
+        double const n = static_cast<double>(iters);
+        samples.push_back(result{c.name, iters, st.elapsed_ns() / n,
+                                 n * st.items_per_iteration() * 1e9 / std::max(st.elapsed_ns(), 1.0),
+                                 static_cast<double>(st.allocations()) / n});
+    }
+    std::sort(samples.begin(), samples.end(),
+              [](const result &a, const result &b) { return a.ns_per_op < b.ns_per_op; });
+    return samples[samples.size() / 2];
+}
+
+void print_text_header()
+{
+    std::printf("hardware_concurrency: %u\n", std::thread::hardware_concurrency());
+    std::printf("%-40s %14s %14s %16s %12s\n", "name", "iterations", "ns/op", "items/s", "allocs/op");
+}
+
+void print_text(const result &r)
+{
+    std::printf("%-40s %14llu %14.1f %16.0f %12.2f\n", r.name.c_str(), static_cast<unsigned long long>(r.iterations),
+                r.ns_per_op, r.items_per_sec, r.allocs_per_op);
+    std::fflush(stdout);
+}
+
+void print_csv(const std::vector<result> &results)
+{
+    std::printf("name,iterations,ns_per_op,items_per_sec,allocs_per_op\n");
+    for (const auto &r : results) {
+        std::printf("%s,%llu,%.3f,%.3f,%.3f\n", r.name.c_str(), static_cast<unsigned long long>(r.iterations),
+                    r.ns_per_op, r.items_per_sec, r.allocs_per_op);
+    }
+}
+
+void print_json(const std::vector<result> &results)
+{
+    std::printf("{\n  \"benchmarks\": [\n");
+    for (std::size_t i = 0; i < results.size(); i++) {
+        const auto &r = results[i];
+        std::printf("    {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.3f, \"items_per_sec\": %.3f, "
+                    "\"allocs_per_op\": %.3f}%s\n",
+                    r.name.c_str(), static_cast<unsigned long long>(r.iterations), r.ns_per_op, r.items_per_sec,
+                    r.allocs_per_op, i + 1 < results.size() ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+}
+
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+    cmdline::parser a;
+    a.add<std::string>("format", 'f', "output format", false, "text",
+                       cmdline::oneof<std::string>("text", "csv", "json"));
+    a.add<std::string>("filter", 0, "only run cases whose name contains this string", false, "");
+    a.add<double>("min-time", 't', "minimum time per measurement in milliseconds", false, 100.0);
+    a.add<int>("repetitions", 'r', "measurements per case, the median is reported", false, 3, cmdline::range(1, 100));
+    a.add("list", 'l', "list cases and exit");
+    a.set_program_name("cmdline_bench");
+    a.parse_check(argc, argv);
+
+    std::vector<bench::case_info> cases = bench::registry();
+    std::sort(cases.begin(), cases.end(),
+              [](const bench::case_info &x, const bench::case_info &y) { return x.name < y.name; });
+
+    bool const text = a.get<std::string>("format") == "text";
+    if (text && !a.exist("list")) {
+        print_text_header();
+    }
+
+    std::vector<result> results;
+    for (const auto &c : cases) {
+        if (c.name.find(a.get<std::string>("filter")) == std::string::npos) {
+            continue;
+        }
+        if (a.exist("list")) {
+            std::printf("%s\n", c.name.c_str());
+            continue;
+        }
+        results.push_back(run(c, a.get<double>("min-time") * 1e6, a.get<int>("repetitions")));
+        if (text) {
+            print_text(results.back());
+        }
+    }
+
+    if (a.get<std::string>("format") == "csv") {
+        print_csv(results);
+    } else if (a.get<std::string>("format") == "json") {
+        print_json(results);
+    }
+    return 0;
+}
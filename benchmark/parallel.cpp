@@ -0,0 +1,78 @@
+#include <cmdline/parallel.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+
+namespace {
+
+/// @brief 模拟读取文件或解析主机名的慢 reader
+struct slow_reader
+{
+    int operator()(const std::string &s) const
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return static_cast<int>(s.size());
+    }
+};
+
+/// @brief 几乎没有开销的 reader，用于测量分发本身的开销
+struct fast_reader
+{
+    int operator()(const std::string &s) const { return static_cast<int>(s.size()); }
+};
+
+template <class F>
+void readers(bench::state &st, cmdline::executor *exec)
+{
+    cmdline::parser p;
+    std::vector<std::string> args = {"prog"};
+    for (int i = 0; i < 8; i++) {
+        std::string const name = "file-" + std::to_string(i);
+        p.add<int, F>(name, 0, "file", false, 0, F());
+        p.independent(name);
+        args.push_back("--" + name + "=/etc/hosts");
+    }
+    p.set_executor(exec);
+
+    std::vector<const char *> argv;
+    for (const auto &a : args) {
+        argv.push_back(a.c_str());
+    }
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        bench::do_not_optimize(p.parse(static_cast<int>(argv.size()), argv.data()));
+    }
+    st.stop();
+}
+
+void serial_slow(bench::state &st)
+{
+    readers<slow_reader>(st, nullptr);
+}
+BENCH_CASE("readers/serial_8x1ms", serial_slow);
+
+void parallel_slow(bench::state &st)
+{
+    static cmdline::thread_pool pool(7);
+    readers<slow_reader>(st, &pool);
+}
+BENCH_CASE("readers/parallel_8x1ms", parallel_slow);
+
+void serial_fast(bench::state &st)
+{
+    readers<fast_reader>(st, nullptr);
+}
+BENCH_CASE("readers/serial_8_trivial", serial_fast);
+
+void parallel_fast(bench::state &st)
+{
+    static cmdline::thread_pool pool(7);
+    readers<fast_reader>(st, &pool);
+}
+BENCH_CASE("readers/parallel_8_trivial", parallel_fast);
+
+}  // namespace
@@ -0,0 +1,494 @@
+#include <cmdline/core.h>
+#include <cmdline/usage.h>
+
+#include <string>
+#include <vector>
+
+#include "bench.h"
+
+namespace {
+
+/// @brief 与 examples/simple 相同的小规模选项集合
+void add_small(cmdline::parser &p)
+{
+    p.add<std::string>("host", 0, "host name", true, "");
+    p.add<int>("port", 'p', "port number", false, 80, cmdline::range(1, 65535));
+    p.add<std::string>("type", 't', "protocol type", false, "http",
+                       cmdline::oneof<std::string>("http", "https", "ssh", "ftp"));
+    p.add<double>("ratio", 'r', "ratio", false, 0.5);
+    p.add("gzip", 'g', "gzip when transfer");
+    p.add("verbose", 'v', "verbose");
+}
+
+/// @brief 大规模选项集合：n 个整数选项和 n 个布尔选项
+void add_huge(cmdline::parser &p, int n)
+{
+    for (int i = 0; i < n; i++) {
+        p.add<int>("value-" + std::to_string(i), 0, "integer value", false, 0);
+        p.add("flag-" + std::to_string(i), 0, "boolean flag");
+    }
+}
+
+std::vector<const char *> pointers(const std::vector<std::string> &args)
+{
+    std::vector<const char *> argv;
+    for (const auto &a : args) {
+        argv.push_back(a.c_str());
+    }
+    return argv;
+}
+
+void tokenize(bench::state &st)
+{
+    cmdline::parser p;
+    add_small(p);
+    std::string const line = "prog --host=github.com -p 8080 --type \"https\" -r 0.25 -gv file\\ one.txt file2.txt";
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        bench::do_not_optimize(p.parse(line));
+    }
+    st.stop();
+}
+BENCH_CASE("parse/string", tokenize);
+
+void cache_hit(bench::state &st)
+{
+    cmdline::parser p;
+    add_small(p);
+    p.enable_cache(16);
+    std::string const line = "prog --host=github.com -p 8080 --type \"https\" -r 0.25 -gv file\\ one.txt file2.txt";
+    p.parse(line);
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        bench::do_not_optimize(p.parse(line));
+    }
+    st.stop();
+}
+BENCH_CASE("cache/string_hit", cache_hit);
+
+template <int N>
+void cache_hit_huge(bench::state &st)
+{
+    cmdline::parser p;
+    add_huge(p, N);
+    p.enable_cache(16);
+    std::vector<std::string> args = {"prog"};
+    for (int i = 0; i < N; i += 10) {
+        args.push_back("--value-" + std::to_string(i) + "=" + std::to_string(i));
+        args.push_back("--flag-" + std::to_string(i));
+    }
+    std::vector<const char *> const argv = pointers(args);
+    p.parse(static_cast<int>(argv.size()), argv.data());
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        bench::do_not_optimize(p.parse(static_cast<int>(argv.size()), argv.data()));
+    }
+    st.stop();
+}
+BENCH_CASE("cache/argv_hit_huge_1000", cache_hit_huge<1000>);
+
+void parse_small(bench::state &st)
+{
+    cmdline::parser p;
+    add_small(p);
+    std::vector<std::string> const args = {"prog", "--host=github.com", "-p", "8080", "--type", "https",
+                                           "-r",   "0.25",              "-g", "-v",   "file1", "file2"};
+    std::vector<const char *> const argv = pointers(args);
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        bench::do_not_optimize(p.parse(static_cast<int>(argv.size()), argv.data()));
+    }
+    st.stop();
+}
+BENCH_CASE("parse/argv_small", parse_small);
+
+template <int N>
+void parse_huge(bench::state &st)
+{
+    cmdline::parser p;
+    add_huge(p, N);
+    std::vector<std::string> args = {"prog"};
+    for (int i = 0; i < N; i += 10) {
+        args.push_back("--value-" + std::to_string(i) + "=" + std::to_string(i));
+        args.push_back("--flag-" + std::to_string(i));
+    }
+    std::vector<const char *> const argv = pointers(args);
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        bench::do_not_optimize(p.parse(static_cast<int>(argv.size()), argv.data()));
+    }
+    st.stop();
+}
+BENCH_CASE("parse/argv_huge_1000", parse_huge<1000>);
+
+/// @brief 与 parse/argv_huge_1000 相同的输入，从二进制编码恢复
+void deserialize_huge(bench::state &st)
+{
+    cmdline::parser p;
+    add_huge(p, 1000);
+    std::vector<std::string> args = {"prog"};
+    for (int i = 0; i < 1000; i += 10) {
+        args.push_back("--value-" + std::to_string(i) + "=" + std::to_string(i));
+        args.push_back("--flag-" + std::to_string(i));
+    }
+    std::vector<const char *> const argv = pointers(args);
+    p.parse(static_cast<int>(argv.size()), argv.data());
+    std::string const blob = p.serialize();
+
+    cmdline::parser q;
+    add_huge(q, 1000);
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        bench::do_not_optimize(q.deserialize(blob));
+    }
+    st.stop();
+}
+BENCH_CASE("handoff/deserialize_huge_1000", deserialize_huge);
+
+void serialize_huge(bench::state &st)
+{
+    cmdline::parser p;
+    add_huge(p, 1000);
+    p.parse("prog --value-1=1 --flag-2 --value-500=500 a b c");
+    std::string blob;
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        blob.clear();
+        p.serialize(blob);
+        bench::do_not_optimize(blob);
+    }
+    st.stop();
+}
+BENCH_CASE("handoff/serialize_huge_1000", serialize_huge);
+
+void parse_bundled(bench::state &st)
+{
+    cmdline::parser p;
+    std::string const letters = "abcdefghijklmnop";
+    for (char c : letters) {
+        p.add(std::string("flag-") + c, c, "flag");
+    }
+    p.add<int>("count", 'x', "count", false, 0);
+    std::vector<std::string> const args = {"prog", "-abcdefgh", "-ijklmnop", "-ax", "42"};
+    std::vector<const char *> const argv = pointers(args);
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        bench::do_not_optimize(p.parse(static_cast<int>(argv.size()), argv.data()));
+    }
+    st.stop();
+}
+BENCH_CASE("parse/bundled_short", parse_bundled);
+
+/// @brief 1000 个整数 ID 作为剩余参数
+std::vector<std::string> id_args()
+{
+    std::vector<std::string> args = {"prog", "-v", "batch.txt"};
+    for (int i = 0; i < 1000; i++) {
+        args.push_back(std::to_string(100000 + i * 7));
+    }
+    return args;
+}
+
+void positional_variadic(bench::state &st)
+{
+    cmdline::parser p;
+    p.add("verbose", 'v', "verbose");
+    p.add_positional<std::string>("input", "input file");
+    p.add_positional<long>("ids", "record ids", cmdline::arity::variadic);
+    std::vector<std::string> const args = id_args();
+    std::vector<const char *> const argv = pointers(args);
+    st.set_items_per_iteration(1000);
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        p.parse(static_cast<int>(argv.size()), argv.data());
+        bench::do_not_optimize(p.get_variadic<long>("ids").back());
+    }
+    st.stop();
+}
+BENCH_CASE("positional/variadic_long_1000", positional_variadic);
+
+/// @brief 对照：解析到 rest() 后由应用逐个转换
+void positional_rest(bench::state &st)
+{
+    cmdline::parser p;
+    p.add("verbose", 'v', "verbose");
+    std::vector<std::string> const args = id_args();
+    std::vector<const char *> const argv = pointers(args);
+    std::vector<long> ids;
+    st.set_items_per_iteration(1000);
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        p.parse(static_cast<int>(argv.size()), argv.data());
+        ids.clear();
+        for (std::size_t k = 1; k < p.rest().size(); k++) {
+            const std::string &s = p.rest()[k];
+            long v = 0;
+            cmdline::detail::converter<long>::from_string(s.data(), s.data() + s.size(), v);
+            ids.push_back(v);
+        }
+        bench::do_not_optimize(ids.back());
+    }
+    st.stop();
+}
+BENCH_CASE("positional/rest_then_convert_1000", positional_rest);
+
+/// @brief 200 个 `--set key=value`，一半用逗号合并
+std::vector<std::string> tunable_args()
+{
+    std::vector<std::string> args = {"prog"};
+    for (int i = 0; i < 200; i += 2) {
+        args.push_back("--set");
+        args.push_back("tunable." + std::to_string((i * 37) % 200) + "=" + std::to_string(i) + ",tunable." +
+                       std::to_string((i * 37 + 1) % 200) + "=" + std::to_string(i + 1));
+    }
+    return args;
+}
+
+void map_collect_int(bench::state &st)
+{
+    cmdline::parser p;
+    p.add_map<int>("set", 's', "tunables");
+    std::vector<std::string> const args = tunable_args();
+    std::vector<const char *> const argv = pointers(args);
+    st.set_items_per_iteration(200);
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        bench::do_not_optimize(p.parse(static_cast<int>(argv.size()), argv.data()));
+    }
+    st.stop();
+}
+BENCH_CASE("map/collect_int_200", map_collect_int);
+
+void map_collect_view(bench::state &st)
+{
+    cmdline::parser p;
+    p.add_map<cmdline::string_ref>("set", 's', "tunables");
+    std::vector<std::string> const args = tunable_args();
+    std::vector<const char *> const argv = pointers(args);
+    st.set_items_per_iteration(200);
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        bench::do_not_optimize(p.parse(static_cast<int>(argv.size()), argv.data()));
+    }
+    st.stop();
+}
+BENCH_CASE("map/collect_view_200", map_collect_view);
+
+void map_find(bench::state &st)
+{
+    cmdline::parser p;
+    p.add_map<int>("set", 's', "tunables");
+    std::vector<std::string> const args = tunable_args();
+    std::vector<const char *> const argv = pointers(args);
+    p.parse(static_cast<int>(argv.size()), argv.data());
+    const cmdline::flat_map<int> &m = p.get_map<int>("set");
+    std::vector<std::string> keys;
+    for (int i = 0; i < 200; i++) {
+        keys.push_back("tunable." + std::to_string(i));
+    }
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        bench::do_not_optimize(m.find(keys[i % keys.size()]));
+    }
+    st.stop();
+}
+BENCH_CASE("map/find_200", map_find);
+
+template <class T>
+void convert(bench::state &st, const std::string &text)
+{
+    cmdline::default_reader<T> reader;
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        bench::do_not_optimize(reader(text));
+    }
+    st.stop();
+}
+
+void convert_int(bench::state &st)
+{
+    convert<int>(st, "1234567");
+}
+BENCH_CASE("convert/int", convert_int);
+
+void convert_double(bench::state &st)
+{
+    convert<double>(st, "3.14159265");
+}
+BENCH_CASE("convert/double", convert_double);
+
+void convert_string(bench::state &st)
+{
+    convert<std::string>(st, "a-string-value-longer-than-sso");
+}
+BENCH_CASE("convert/string", convert_string);
+
+void validate_range(bench::state &st)
+{
+    cmdline::range_reader<int> const reader = cmdline::range(1, 65535);
+    std::string const text = "8080";
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        bench::do_not_optimize(reader(text));
+    }
+    st.stop();
+}
+BENCH_CASE("validate/range", validate_range);
+
+void validate_oneof(bench::state &st)
+{
+    cmdline::oneof_reader<std::string> reader = cmdline::oneof<std::string>("http", "https", "ssh", "ftp");
+    std::string const text = "ftp";
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        bench::do_not_optimize(reader(text));
+    }
+    st.stop();
+}
+BENCH_CASE("validate/oneof", validate_oneof);
+
+void read_get(bench::state &st)
+{
+    cmdline::parser p;
+    add_small(p);
+    p.parse("prog --host=github.com -p 8080");
+    std::string const name = "port";
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        bench::do_not_optimize(p.get<int>(name));
+    }
+    st.stop();
+}
+BENCH_CASE("read/get", read_get);
+
+void read_exist(bench::state &st)
+{
+    cmdline::parser p;
+    add_huge(p, 1000);
+    p.parse("prog --flag-500");
+    std::string const name = "flag-500";
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        bench::do_not_optimize(p.exist(name));
+    }
+    st.stop();
+}
+BENCH_CASE("read/exist_1000", read_exist);
+
+void read_exist_handle(bench::state &st)
+{
+    cmdline::parser p;
+    add_huge(p, 1000);
+    p.parse("prog --flag-500");
+    cmdline::flag_handle const h = p.flag("flag-500");
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        bench::do_not_optimize(p.exist(h));
+    }
+    st.stop();
+}
+BENCH_CASE("read/exist_handle_1000", read_exist_handle);
+
+void read_any_mask(bench::state &st)
+{
+    cmdline::parser p;
+    add_huge(p, 1000);
+    p.parse("prog --flag-999");
+    std::vector<std::string> names;
+    for (int i = 0; i < 1000; i += 2) {
+        names.push_back("flag-" + std::to_string(i));
+    }
+    cmdline::flag_set const m = p.mask(names);
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        bench::do_not_optimize(p.any(m));
+    }
+    st.stop();
+}
+BENCH_CASE("read/any_mask_1000", read_any_mask);
+
+void read_snapshot(bench::state &st)
+{
+    cmdline::parser p;
+    add_huge(p, 1000);
+    p.parse("prog --flag-1 --flag-500 --value-3=4");
+    cmdline::flag_set const before = p.flags();
+    cmdline::flag_set now;
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        p.flags(now);
+        bench::do_not_optimize(now == before);
+    }
+    st.stop();
+}
+BENCH_CASE("read/flags_snapshot_compare_1000", read_snapshot);
+
+/// @brief 1000 个选项上的 100 条约束：flag-i 依赖 value-i，与 flag-(i+1) 冲突
+std::vector<std::string> constraint_args()
+{
+    std::vector<std::string> args = {"prog"};
+    for (int i = 0; i < 100; i += 10) {
+        args.push_back("--flag-" + std::to_string(i));
+        args.push_back("--value-" + std::to_string(i) + "=1");
+    }
+    return args;
+}
+
+void constraint_declared(bench::state &st)
+{
+    cmdline::parser p;
+    add_huge(p, 1000);
+    for (int i = 0; i < 50; i++) {
+        p.depends_on("flag-" + std::to_string(i), {"value-" + std::to_string(i)});
+        p.conflicts_with("flag-" + std::to_string(i), {"flag-" + std::to_string(i + 1)});
+    }
+    std::vector<std::string> const args = constraint_args();
+    std::vector<const char *> const argv = pointers(args);
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        bench::do_not_optimize(p.parse(static_cast<int>(argv.size()), argv.data()));
+    }
+    st.stop();
+}
+BENCH_CASE("constraint/declared_100", constraint_declared);
+
+/// @brief 同样的约束在每次解析后按名称手动检查
+void constraint_manual(bench::state &st)
+{
+    cmdline::parser p;
+    add_huge(p, 1000);
+    std::vector<std::string> flags;
+    std::vector<std::string> values;
+    for (int i = 0; i <= 50; i++) {
+        flags.push_back("flag-" + std::to_string(i));
+        values.push_back("value-" + std::to_string(i));
+    }
+    std::vector<std::string> const args = constraint_args();
+    std::vector<const char *> const argv = pointers(args);
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        bool ok = p.parse(static_cast<int>(argv.size()), argv.data());
+        for (std::size_t k = 0; k < 50; k++) {
+            if (p.exist(flags[k])) {
+                ok = ok && p.exist(values[k]) && !p.exist(flags[k + 1]);
+            }
+        }
+        bench::do_not_optimize(ok);
+    }
+    st.stop();
+}
+BENCH_CASE("constraint/manual_100", constraint_manual);
+
+void usage(bench::state &st)
+{
+    cmdline::parser p;
+    add_small(p);
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        bench::do_not_optimize(p.usage());
+    }
+    st.stop();
+}
+BENCH_CASE("usage/small", usage);
+
+}  // namespace
@@ -0,0 +1,86 @@
+#include <cmdline/reloadable.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+
+namespace {
+
+void spec(cmdline::parser &p)
+{
+    p.add<int>("port", 'p', "port number", true, 0);
+    p.add<std::string>("host", 0, "host name", true, "");
+    p.add("verbose", 'v', "verbose");
+}
+
+/// @brief 多个读者线程不停读取，主线程每次迭代重新加载一次
+/// @details 每个快照中 host 必须与 port 对应，否则说明读到了不完整的快照
+template <int Readers>
+void reload_under_readers(bench::state &st)
+{
+    cmdline::reloadable config(spec);
+    config.reload("prog -p 0 --host=h0");
+
+    std::atomic<bool> stop{false};
+    std::atomic<std::uint64_t> reads{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < Readers; t++) {
+        threads.emplace_back([&config, &stop, &reads] {
+            cmdline::reloadable::reader r(config);
+            std::uint64_t n = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                const cmdline::parser *p = r.get();
+                int const port = p->get<int>("port");
+                if (p->get<std::string>("host") != "h" + std::to_string(port)) {
+                    std::fprintf(stderr, "inconsistent snapshot: port %d host %s\n", port,
+                                 p->get<std::string>("host").c_str());
+                    std::abort();
+                }
+                n++;
+            }
+            reads += n;
+        });
+    }
+
+    std::vector<std::string> lines;
+    for (int k = 1; k <= 64; k++) {
+        lines.push_back("prog -v -p " + std::to_string(k) + " --host=h" + std::to_string(k));
+    }
+
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        if (!config.reload(lines[i % lines.size()])) {
+            std::abort();
+        }
+    }
+    st.stop();
+
+    stop = true;
+    for (auto &t : threads) {
+        t.join();
+    }
+    bench::do_not_optimize(reads.load());
+}
+BENCH_CASE("reload/readers_1", reload_under_readers<1>);
+BENCH_CASE("reload/readers_8", reload_under_readers<8>);
+
+/// @brief 配置不变时读者的开销
+void reader_get(bench::state &st)
+{
+    cmdline::reloadable config(spec);
+    config.reload("prog -p 80 --host=h80");
+    cmdline::reloadable::reader r(config);
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        bench::do_not_optimize(r.get());
+    }
+    st.stop();
+}
+BENCH_CASE("reload/reader_get", reader_get);
+
+}  // namespace
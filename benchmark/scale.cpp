@@ -0,0 +1,120 @@
+/// @file scale.cpp
+/// @brief 选项数量从 100 到 100k 时注册和解析的开销
+/// @details
+/// 选项名按乱序生成，逐个 add() 时每次都插入到索引中间，add_table() 只排序和归并一次。
+#include <cmdline/core.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+
+namespace {
+
+/// @brief n 个互不相同、不按字典序出现的选项名，偶数项为整数选项，奇数项为布尔选项
+std::vector<std::string> scrambled_names(int n)
+{
+    std::vector<std::string> names;
+    names.reserve(static_cast<std::size_t>(n));
+    char buf[32];
+    for (int i = 0; i < n; i++) {
+        // 乘以奇数在 2^32 下是一一映射，名称不会重复
+        std::uint32_t const key = static_cast<std::uint32_t>(i) * 2654435761u;
+        std::snprintf(buf, sizeof(buf), "opt-%08x", static_cast<unsigned>(key));
+        names.push_back(buf);
+    }
+    return names;
+}
+
+std::vector<cmdline::option_def> table_of(const std::vector<std::string> &names)
+{
+    std::vector<cmdline::option_def> table;
+    table.reserve(names.size());
+    for (std::size_t i = 0; i < names.size(); i++) {
+        if (i % 2 == 0) {
+            table.push_back({names[i].c_str(), 0, "integer value", cmdline::option_kind::integer, false, "0"});
+        } else {
+            table.push_back({names[i].c_str(), 0, "boolean flag", cmdline::option_kind::flag, false, nullptr});
+        }
+    }
+    return table;
+}
+
+template <int N>
+void register_add(bench::state &st)
+{
+    std::vector<std::string> const names = scrambled_names(N);
+    st.set_items_per_iteration(N);
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        cmdline::parser p;
+        for (std::size_t k = 0; k < names.size(); k++) {
+            if (k % 2 == 0) {
+                p.add<int>(names[k], 0, "integer value", false, 0);
+            } else {
+                p.add(names[k], 0, "boolean flag");
+            }
+        }
+        bench::do_not_optimize(p.exist(names[0]));
+    }
+    st.stop();
+}
+BENCH_CASE("scale/register_add_100", register_add<100>);
+BENCH_CASE("scale/register_add_1k", register_add<1000>);
+BENCH_CASE("scale/register_add_10k", register_add<10000>);
+BENCH_CASE("scale/register_add_100k", register_add<100000>);
+
+template <int N>
+void register_table(bench::state &st)
+{
+    std::vector<std::string> const names = scrambled_names(N);
+    std::vector<cmdline::option_def> const table = table_of(names);
+    st.set_items_per_iteration(N);
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        cmdline::parser p;
+        p.add_table(table.data(), table.size());
+        bench::do_not_optimize(p.exist(names[0]));
+    }
+    st.stop();
+}
+BENCH_CASE("scale/register_table_100", register_table<100>);
+BENCH_CASE("scale/register_table_1k", register_table<1000>);
+BENCH_CASE("scale/register_table_10k", register_table<10000>);
+BENCH_CASE("scale/register_table_100k", register_table<100000>);
+
+/// @brief 每次解析给出 16 个选项，与选项总数无关
+template <int N>
+void parse_scaled(bench::state &st)
+{
+    std::vector<std::string> const names = scrambled_names(N);
+    std::vector<cmdline::option_def> const table = table_of(names);
+    cmdline::parser p;
+    p.add_table(table.data(), table.size());
+    std::vector<std::string> args = {"prog"};
+    for (int k = 0; k < 16; k++) {
+        std::size_t const pick = static_cast<std::size_t>(k) * (N / 16);
+        if (pick % 2 == 0) {
+            args.push_back("--" + names[pick] + "=" + std::to_string(k));
+        } else {
+            args.push_back("--" + names[pick]);
+        }
+    }
+    std::vector<const char *> argv;
+    for (const auto &a : args) {
+        argv.push_back(a.c_str());
+    }
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        bench::do_not_optimize(p.parse(static_cast<int>(argv.size()), argv.data()));
+    }
+    st.stop();
+}
+BENCH_CASE("scale/parse_100", parse_scaled<100>);
+BENCH_CASE("scale/parse_1k", parse_scaled<1000>);
+BENCH_CASE("scale/parse_10k", parse_scaled<10000>);
+BENCH_CASE("scale/parse_100k", parse_scaled<100000>);
+
+}  // namespace
@@ -0,0 +1,118 @@
+/// @file units.cpp
+/// @brief 带单位的 reader 与手写的 stringstream 转换的对比
+#include <cmdline/units.h>
+
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+#include "bench.h"
+
+namespace {
+
+/// @brief 常见的手写方式：用流读出数字和单位，再逐个比较单位
+struct stream_bytes
+{
+    std::uint64_t operator()(const std::string &s) const
+    {
+        std::istringstream in(s);
+        double value = 0;
+        std::string unit;
+        if (!(in >> value)) {
+            throw cmdline::cmdline_error("bad cast");
+        }
+        in >> unit;
+        double scale = 1;
+        if (unit == "KiB") {
+            scale = 1024.0;
+        } else if (unit == "MiB") {
+            scale = 1024.0 * 1024;
+        } else if (unit == "GiB") {
+            scale = 1024.0 * 1024 * 1024;
+        } else if (!unit.empty() && unit != "B") {
+            throw cmdline::cmdline_error("bad unit");
+        }
+        return static_cast<std::uint64_t>(value * scale);
+    }
+};
+
+struct stream_duration
+{
+    std::chrono::milliseconds operator()(const std::string &s) const
+    {
+        std::istringstream in(s);
+        double value = 0;
+        std::string unit;
+        if (!(in >> value)) {
+            throw cmdline::cmdline_error("bad cast");
+        }
+        in >> unit;
+        double scale = 1;
+        if (unit == "s") {
+            scale = 1000;
+        } else if (unit == "m") {
+            scale = 60000;
+        } else if (unit != "ms") {
+            throw cmdline::cmdline_error("bad unit");
+        }
+        return std::chrono::milliseconds(static_cast<std::int64_t>(value * scale));
+    }
+};
+
+struct stream_rate
+{
+    double operator()(const std::string &s) const
+    {
+        std::istringstream in(s);
+        double value = 0;
+        std::string unit;
+        if (!(in >> value)) {
+            throw cmdline::cmdline_error("bad cast");
+        }
+        in >> unit;
+        if (!unit.empty() && unit[0] == 'k') {
+            value *= 1000;
+            unit.erase(0, 1);
+        }
+        if (unit != "/s" && !unit.empty()) {
+            throw cmdline::cmdline_error("bad unit");
+        }
+        return value;
+    }
+};
+
+const char *const unit_args[] = {"prog", "--cache=512MiB", "--timeout=250ms", "--rate=10k/s"};
+int const unit_argc = 4;
+
+void units_reader(bench::state &st)
+{
+    cmdline::parser p;
+    p.add<std::uint64_t>("cache", 0, "cache size", false, 64 << 20, cmdline::byte_size("1MiB", "64GiB"));
+    p.add<std::chrono::milliseconds>("timeout", 0, "timeout", false, std::chrono::milliseconds(1000),
+                                     cmdline::duration<std::chrono::milliseconds>("1ms", "30s"));
+    p.add<double>("rate", 0, "rate limit", false, 100, cmdline::rate("1/s", "100k/s"));
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        bench::do_not_optimize(p.parse(unit_argc, unit_args));
+    }
+    st.stop();
+}
+BENCH_CASE("units/reader", units_reader);
+
+void units_stream(bench::state &st)
+{
+    cmdline::parser p;
+    p.add<std::uint64_t>("cache", 0, "cache size", false, 64 << 20, stream_bytes());
+    p.add<std::chrono::milliseconds>("timeout", 0, "timeout", false, std::chrono::milliseconds(1000),
+                                     stream_duration());
+    p.add<double>("rate", 0, "rate limit", false, 100, stream_rate());
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        bench::do_not_optimize(p.parse(unit_argc, unit_args));
+    }
+    st.stop();
+}
+BENCH_CASE("units/stringstream", units_stream);
+
+}  // namespace
@@ -0,0 +1,97 @@
+#include <cmdline/core.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bench.h"
+
+namespace {
+
+/// @brief 8MiB 的字符串
+const std::string &big_string()
+{
+    static const std::string s(8 << 20, 'x');
+    return s;
+}
+
+void register_copy(bench::state &st)
+{
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        cmdline::parser p;
+        p.add<std::string>("blob", 0, "payload", false, big_string());
+        bench::do_not_optimize(p.get<std::string>("blob").size());
+    }
+    st.stop();
+}
+BENCH_CASE("value/register_copy_8MiB", register_copy);
+
+void register_move(bench::state &st)
+{
+    // 分批准备默认值，准备的时间不计入，同时存在的默认值不超过一批
+    const std::uint64_t batch = 16;
+    std::vector<std::string> defaults(batch);
+    for (std::uint64_t done = 0; done < st.iterations(); done += batch) {
+        std::uint64_t const n = st.iterations() - done < batch ? st.iterations() - done : batch;
+        for (std::uint64_t i = 0; i < n; i++) {
+            defaults[i] = big_string();
+        }
+        st.start();
+        for (std::uint64_t i = 0; i < n; i++) {
+            cmdline::parser p;
+            p.add<std::string>("blob", 0, "payload", false, std::move(defaults[i]));
+            bench::do_not_optimize(p.get<std::string>("blob").size());
+        }
+        st.stop();
+    }
+}
+BENCH_CASE("value/register_move_8MiB", register_move);
+
+/// @brief 程序启动时的用法：解析一次 --blob=<8MiB>，然后由应用持有值
+template <bool Take>
+void extract(bench::state &st)
+{
+    std::string const arg = "--blob=" + big_string();
+    const char *argv[] = {"prog", arg.c_str()};
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        cmdline::parser p;
+        p.add<std::string>("blob", 0, "payload", false, "");
+        cmdline::value_handle<std::string> const h = p.handle<std::string>("blob");
+        p.parse(2, argv);
+        std::string const value = Take ? p.take(h) : p.get(h);
+        bench::do_not_optimize(value.size());
+    }
+    st.stop();
+}
+BENCH_CASE("value/parse_get_copy_8MiB", extract<false>);
+BENCH_CASE("value/parse_take_8MiB", extract<true>);
+
+/// @brief 解析一次 100000 个文件名的剩余参数，然后由应用持有整个数组
+template <bool Take>
+void extract_variadic(bench::state &st)
+{
+    std::vector<std::string> args = {"prog"};
+    for (int i = 0; i < 100000; i++) {
+        args.push_back("/data/shard-" + std::to_string(i) + "/records.bin");
+    }
+    std::vector<const char *> argv;
+    for (const auto &a : args) {
+        argv.push_back(a.c_str());
+    }
+    st.start();
+    for (std::uint64_t i = 0; i < st.iterations(); i++) {
+        cmdline::parser p;
+        p.add_positional<std::string>("files", "input files", cmdline::arity::variadic);
+        p.parse(static_cast<int>(argv.size()), argv.data());
+        std::vector<std::string> const files =
+            Take ? p.take_variadic<std::string>("files") : p.get_variadic<std::string>("files");
+        bench::do_not_optimize(files.size());
+    }
+    st.stop();
+}
+BENCH_CASE("value/variadic_get_copy_100k", extract_variadic<false>);
+BENCH_CASE("value/variadic_take_100k", extract_variadic<true>);
+
+}  // namespace
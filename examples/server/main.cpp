@@ -0,0 +1,75 @@
+#include <cmdline/server.h>
+#include <cmdline/usage.h>
+
+#include <csignal>
+#include <iostream>
+
+namespace {
+
+cmdline::server *running = nullptr;
+
+void on_signal(int /*sig*/)
+{
+    if (running != nullptr) {
+        running->stop();
+    }
+}
+
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+    cmdline::parser a;
+    a.add<std::string>("unix", 'u', "unix socket path", false, "");
+    a.add<int>("port", 'p', "tcp port on 127.0.0.1", false, 7000, cmdline::range(0, 65535));
+    a.parse_check(argc, argv);
+
+    // 与 examples/shell 相同的命令，每个连接是一个独立的会话
+    cmdline::server srv(
+        [](cmdline::parser &p) {
+            p.add<std::string>("host", 0, "host name", true, "");
+            p.add<int>("port", 'p', "port number", false, 80, cmdline::range(1, 65535));
+            p.add<std::string>("type", 't', "protocol type", false, "http",
+                               cmdline::oneof<std::string>("http", "https", "ssh", "ftp"));
+            p.add("quit", 'q', "quit");
+            p.add("help", 'h', "print this message");
+            p.footer("filename ...");
+            p.set_program_name("server");
+        },
+        [](cmdline::server::session &s, const cmdline::parser &p, bool ok) {
+            if (p.exist("quit")) {
+                s.write("bye\n");
+                s.close();
+                return;
+            }
+            if (p.exist("help")) {
+                s.write(p.usage());
+                return;
+            }
+            if (!ok) {
+                s.write(p.error() + "\n");
+                return;
+            }
+            s.write(p.get<std::string>("host") + ":" + std::to_string(p.get<int>("port")) + "\n");
+        });
+    srv.spec().enable_cache(256);
+
+    bool const ok = a.get<std::string>("unix").empty()
+                        ? srv.listen_tcp("127.0.0.1", static_cast<std::uint16_t>(a.get<int>("port")))
+                        : srv.listen_unix(a.get<std::string>("unix"));
+    if (!ok) {
+        std::cerr << "listen failed: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    if (a.get<std::string>("unix").empty()) {
+        std::cout << "listening on 127.0.0.1:" << srv.port() << std::endl;
+    } else {
+        std::cout << "listening on " << a.get<std::string>("unix") << std::endl;
+    }
+
+    running = &srv;
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+    srv.run();
+    return 0;
+}
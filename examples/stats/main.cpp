@@ -0,0 +1,35 @@
+#include <cmdline/cmdline.h>
+#include <cmdline/trace.h>
+
+#include <fstream>
+#include <iostream>
+
+int main(int argc, char *argv[])
+{
+    cmdline::parser a;
+    a.add<std::string>("host", '\0', "host name", false, "localhost");
+    a.add<int>("port", 'p', "port number", false, 80, cmdline::range(1, 65535));
+    a.add<std::string>("type", 't', "protocol type", false, "http",
+                       cmdline::oneof<std::string>("http", "https", "ssh", "ftp"));
+    a.add<std::string>("trace", '\0', "write a Chrome trace of the parses to this file", false, "");
+    a.add("gzip", '\0', "gzip when transfer");
+
+    // 每次解析都采样
+    cmdline::stats_sampler sampler;
+    sampler.attach(a);
+
+    a.parse_check(argc, argv);
+
+    // 再按同样的输入解析几次，观察稳态下的耗时
+    for (int i = 0; i < 3; i++) {
+        a.parse(argc, argv);
+    }
+
+    cmdline::write_json(std::cout, a.stats());
+
+    if (!a.get<std::string>("trace").empty()) {
+        std::ofstream out(a.get<std::string>("trace"));
+        sampler.write_chrome_trace(out);
+    }
+    return 0;
+}
@@ -0,0 +1,433 @@
+/// @file batch.h
+/// @author moth (QianMoth@qq.com)
+/// @brief 批量解析按行给出的命令
+/// @details
+/// 输入每行是一条完整的命令行(与 parser::parse(const std::string &) 相同，第一个词是程序名)，
+/// 来自 std::istream、内存或映射到内存的文件。输入按窗口整块读入后一次切分成行，每若干行为一块，
+/// 各工作槽先处理分给自己的块，做完后从其他槽的末尾窃取。每个工作槽有一个用同一份选项定义构造的 parser。
+///
+/// @copyright Copyright (c) 2009, Hideyuki Tanaka
+///
+#pragma once
+
+#include "core.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#endif
+
+namespace cmdline {
+
+/// @brief batch 交付结果的顺序
+enum class delivery
+{
+    /// @brief 按行号顺序，回调不会并发调用
+    ordered,
+    /// @brief 解析完立即交付，回调在各工作线程上并发调用
+    unordered
+};
+
+/// @brief 批量解析器
+/// @code
+/// ```cpp
+/// cmdline::thread_pool pool(std::thread::hardware_concurrency() - 1);
+/// cmdline::batch b([](cmdline::parser &p) { p.add<std::string>("host", 0, "host name", true, ""); }, &pool,
+///                  pool.size() + 1);
+/// b.parse_file("commands.txt", [](std::size_t line, const cmdline::parser &p, bool ok) {
+///     if (!ok) { std::fprintf(stderr, "%zu: %s\n", line + 1, p.error().c_str()); }
+/// });
+/// ```
+/// @endcode
+class batch
+{
+  public:
+    /// @brief 在空的解析器上添加所有选项
+    typedef std::function<void(parser &)> spec_fn;
+    /// @brief 处理一行的结果，line 从0开始；parser 中的结果只在回调返回前有效，回调不能抛出异常
+    typedef std::function<void(std::size_t line, const parser &, bool ok)> line_fn;
+
+    /// @brief 构造
+    /// @details 工作槽比处理器核数多时，多出来的槽只会互相抢占，吞吐量不再增加，
+    /// 所以默认不超过 std::thread::hardware_concurrency()(无法获取时不限制)。
+    /// @param spec 选项定义，每个工作槽调用一次，按序交付另外调用一次
+    /// @param pool 执行器，nullptr 时在调用线程上依次处理；使用 thread_pool 时调用线程也参与执行
+    /// @param workers 工作槽数，通常是执行器的线程数加1；为0时等于核数
+    /// @param oversubscribe 为 true 时不按核数限制工作槽数，用于测试
+    explicit batch(const spec_fn &spec, executor *pool = nullptr, std::size_t workers = 1, bool oversubscribe = false)
+        : pool(pool)
+    {
+        std::size_t const cores = std::thread::hardware_concurrency();
+        if (workers == 0 || (!oversubscribe && cores != 0 && workers > cores)) {
+            workers = cores != 0 ? cores : 1;
+        }
+        slots.reserve(workers);
+        do {
+            slots.emplace_back(new slot());
+            spec(slots.back()->cmd);
+        } while (slots.size() < workers);
+        spec(replay);
+    }
+
+    batch(const batch &) = delete;
+    batch &operator=(const batch &) = delete;
+
+    /// @brief 每次整块处理的输入字节数，按序交付时未交付的结果最多占用这么多行
+    void set_window(std::size_t bytes) { window = bytes != 0 ? bytes : 1; }
+
+    /// @brief 每块的行数，是分配和窃取的单位
+    void set_chunk_lines(std::size_t n) { chunk_lines = n != 0 ? n : 1; }
+
+    /// @brief 实际的工作槽数
+    std::size_t workers() const { return slots.size(); }
+
+    /// @brief 解析内存中的所有行
+    /// @param data
+    /// @param size
+    /// @param fn
+    /// @param order
+    /// @return std::size_t 行数
+    std::size_t parse_many(const char *data, std::size_t size, const line_fn &fn,
+                           delivery order = delivery::ordered)
+    {
+        std::size_t total = 0;
+        std::size_t pos = 0;
+        while (pos < size) {
+            std::size_t end = size - pos > window ? pos + window : size;
+            if (end < size) {
+                const void *const nl = std::memchr(data + end, '\n', size - end);
+                end = nl != nullptr ? static_cast<std::size_t>(static_cast<const char *>(nl) - data) + 1 : size;
+            }
+            total += run(data + pos, end - pos, total, fn, order);
+            pos = end;
+        }
+        return total;
+    }
+
+    /// @brief 解析流中的所有行，按窗口整块读取
+    /// @param in
+    /// @param fn
+    /// @param order
+    /// @return std::size_t 行数
+    std::size_t parse_many(std::istream &in, const line_fn &fn, delivery order = delivery::ordered)
+    {
+        std::size_t total = 0;
+        std::size_t kept = 0;
+        while (true) {
+            if (buffer.size() < kept + window) {
+                buffer.resize(kept + window);
+            }
+            in.read(&buffer[kept], static_cast<std::streamsize>(window));
+            std::size_t const filled = kept + static_cast<std::size_t>(in.gcount());
+            bool const eof = !in;
+            // 只处理到最后一个换行，剩下的半行留到下一次
+            std::size_t used = filled;
+            if (!eof) {
+                while (used > 0 && buffer[used - 1] != '\n') {
+                    used--;
+                }
+            }
+            if (used > 0) {
+                total += run(buffer.data(), used, total, fn, order);
+            }
+            if (eof) {
+                return total;
+            }
+            kept = filled - used;
+            std::memmove(&buffer[0], buffer.data() + used, kept);
+        }
+    }
+
+    /// @brief 解析文件中的所有行，POSIX 系统上映射到内存
+    /// @param path
+    /// @param fn
+    /// @param order
+    /// @return std::size_t 行数
+    std::size_t parse_file(const std::string &path, const line_fn &fn, delivery order = delivery::ordered)
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        struct mapping
+        {
+            int fd{-1};
+            void *data{MAP_FAILED};
+            std::size_t size{0};
+            ~mapping()
+            {
+                if (data != MAP_FAILED) {
+                    ::munmap(data, size);
+                }
+                if (fd >= 0) {
+                    ::close(fd);
+                }
+            }
+        } file;
+        struct stat st;
+        file.fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (file.fd < 0 || ::fstat(file.fd, &st) != 0) {
+            throw cmdline_error("cannot open file: " + path + ": " + std::strerror(errno));
+        }
+        file.size = static_cast<std::size_t>(st.st_size);
+        if (file.size == 0) {
+            return 0;
+        }
+        file.data = ::mmap(nullptr, file.size, PROT_READ, MAP_PRIVATE, file.fd, 0);
+        if (file.data == MAP_FAILED) {
+            throw cmdline_error("cannot map file: " + path + ": " + std::strerror(errno));
+        }
+        ::madvise(file.data, file.size, MADV_SEQUENTIAL);
+        return parse_many(static_cast<const char *>(file.data), file.size, fn, order);
+#else
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            throw cmdline_error("cannot open file: " + path);
+        }
+        return parse_many(in, fn, order);
+#endif
+    }
+
+  private:
+    /// @brief 一个工作槽
+    struct slot
+    {
+        parser cmd{};
+        std::string line{};
+        /// @brief 按序交付时一行的编码结果
+        std::string encoded{};
+        /// @brief 分给这个槽还没有处理的块，高32位是头，低32位是尾；自己从头取，其他槽从尾窃取
+        std::atomic<std::uint64_t> range{0};
+    };
+
+    struct line_ref
+    {
+        const char *data;
+        std::size_t size;
+    };
+
+    /// @brief 处理一个窗口：切分成行，分块并行解析，交付全部结果后返回
+    std::size_t run(const char *data, std::size_t size, std::size_t first, const line_fn &fn, delivery order)
+    {
+        lines.clear();
+        const char *p = data;
+        const char *const end = data + size;
+        while (p < end) {
+            const char *nl = static_cast<const char *>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+            const char *const next = nl != nullptr ? nl + 1 : end;
+            if (nl == nullptr) {
+                nl = end;
+            }
+            if (nl > p && nl[-1] == '\r') {
+                nl--;
+            }
+            lines.push_back(line_ref{p, static_cast<std::size_t>(nl - p)});
+            p = next;
+        }
+
+        chunks = (lines.size() + chunk_lines - 1) / chunk_lines;
+        first_line = first;
+        callback = &fn;
+        mode = order;
+        if (order == delivery::ordered) {
+            if (results.size() < chunks) {
+                results.resize(chunks);
+                finished.reset(new std::atomic<bool>[chunks]);
+            }
+            for (std::size_t c = 0; c < chunks; c++) {
+                finished[c].store(false, std::memory_order_relaxed);
+            }
+            cursor.store(0, std::memory_order_relaxed);
+        }
+
+        std::size_t const n = slots.size();
+        for (std::size_t s = 0; s < n; s++) {
+            std::uint64_t const head = chunks * s / n;
+            std::uint64_t const tail = chunks * (s + 1) / n;
+            slots[s]->range.store(head << 32 | tail, std::memory_order_relaxed);
+        }
+        if (pool != nullptr && n > 1) {
+            pool->run(n, &batch::work_entry, this);
+        } else {
+            for (std::size_t s = 0; s < n; s++) {
+                work(s);
+            }
+        }
+
+        if (order == delivery::ordered) {
+            std::lock_guard<std::mutex> const lock(delivering);
+            deliver_finished();
+        }
+        return lines.size();
+    }
+
+    static void work_entry(void *context, std::size_t s) { static_cast<batch *>(context)->work(s); }
+
+    void work(std::size_t s)
+    {
+        std::size_t c = 0;
+        while (take_own(s, c) || steal(s, c)) {
+            process(*slots[s], c);
+        }
+    }
+
+    bool take_own(std::size_t s, std::size_t &c)
+    {
+        std::atomic<std::uint64_t> &range = slots[s]->range;
+        std::uint64_t r = range.load(std::memory_order_acquire);
+        while ((r >> 32) < (r & 0xffffffffu)) {
+            if (range.compare_exchange_weak(r, r + (std::uint64_t(1) << 32), std::memory_order_acq_rel)) {
+                c = static_cast<std::size_t>(r >> 32);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool steal(std::size_t s, std::size_t &c)
+    {
+        for (std::size_t i = 1; i < slots.size(); i++) {
+            std::atomic<std::uint64_t> &range = slots[(s + i) % slots.size()]->range;
+            std::uint64_t r = range.load(std::memory_order_acquire);
+            while ((r >> 32) < (r & 0xffffffffu)) {
+                if (range.compare_exchange_weak(r, r - 1, std::memory_order_acq_rel)) {
+                    c = static_cast<std::size_t>((r & 0xffffffffu) - 1);
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool parse_line(slot &own, std::size_t i)
+    {
+        own.line.assign(lines[i].data, lines[i].size);
+        return own.cmd.parse(own.line);
+    }
+
+    void process(slot &own, std::size_t c)
+    {
+        std::size_t const begin = c * chunk_lines;
+        std::size_t const end = begin + chunk_lines < lines.size() ? begin + chunk_lines : lines.size();
+        if (mode == delivery::unordered) {
+            for (std::size_t i = begin; i < end; i++) {
+                bool const ok = parse_line(own, i);
+                (*callback)(first_line + i, own.cmd, ok);
+            }
+            return;
+        }
+
+        // 逐行检查这个块是否轮到交付：轮到时先交付已经编码的行，剩下的行用自己的 parser 直接交付，
+        // 不再编码，也不会因为值不能编码而在交付时重新解析
+        std::string &out = results[c];
+        out.clear();
+        for (std::size_t i = begin; i < end; i++) {
+            if (cursor.load() == c && delivering.try_lock()) {
+                if (cursor.load(std::memory_order_relaxed) == c) {
+                    deliver_encoded(c);
+                    for (; i < end; i++) {
+                        bool const ok = parse_line(own, i);
+                        (*callback)(first_line + i, own.cmd, ok);
+                    }
+                    cursor.store(c + 1);
+                    deliver_finished();
+                    delivering.unlock();
+                    try_deliver();
+                    return;
+                }
+                delivering.unlock();
+            }
+            bool const ok = parse_line(own, i);
+            own.encoded.clear();
+            own.cmd.serialize(own.encoded);
+            out.push_back(ok ? '\1' : '\0');
+            detail::put_bytes(out, own.encoded.data(), own.encoded.size());
+        }
+        finished[c].store(true);
+        try_deliver();
+    }
+
+    /// @brief 交付块 c 中已经编码的行，调用者持有 delivering
+    void deliver_encoded(std::size_t c)
+    {
+        const char *p = results[c].data();
+        const char *const end = p + results[c].size();
+        for (std::size_t i = c * chunk_lines; p < end; i++) {
+            bool const ok = *p++ != '\0';
+            const char *data = nullptr;
+            std::size_t size = 0;
+            detail::get_bytes(p, end, data, size);
+            if (!replay.deserialize(data, size)) {
+                // 结果中有不能编码的值，在交付时重新解析
+                replay_line.assign(lines[i].data, lines[i].size);
+                replay.parse(replay_line);
+            }
+            (*callback)(first_line + i, replay, ok);
+        }
+    }
+
+    /// @brief 交付从 cursor 开始连续完成的块，调用者持有 delivering
+    void deliver_finished()
+    {
+        for (std::size_t c = cursor.load(); c < chunks && finished[c].load(); c = cursor.load()) {
+            deliver_encoded(c);
+            cursor.store(c + 1);
+        }
+    }
+
+    /// @brief 没有其他线程在交付时交付已完成的块
+    void try_deliver()
+    {
+        while (delivering.try_lock()) {
+            deliver_finished();
+            delivering.unlock();
+            // 持有锁的线程检查之后、解锁之前完成的块，完成它的线程 try_lock 失败，由这里补上
+            std::size_t const c = cursor.load();
+            if (c >= chunks || !finished[c].load()) {
+                return;
+            }
+        }
+    }
+
+    executor *pool;
+    std::vector<std::unique_ptr<slot>> slots{};
+    /// @brief 按序交付时用来恢复编码结果
+    parser replay{};
+    /// @brief 不能编码的结果重新解析时的行
+    std::string replay_line{};
+
+    std::size_t window{std::size_t(1) << 20};
+    std::size_t chunk_lines{256};
+    /// @brief parse_many(std::istream &) 的读取缓冲区
+    std::string buffer{};
+
+    // 当前窗口
+    std::vector<line_ref> lines{};
+    std::size_t chunks{0};
+    std::size_t first_line{0};
+    const line_fn *callback{nullptr};
+    delivery mode{delivery::ordered};
+
+    // 按序交付
+    std::vector<std::string> results{};
+    std::unique_ptr<std::atomic<bool>[]> finished{};
+    /// @brief 下一个要交付的块，只在持有 delivering 时修改
+    std::atomic<std::size_t> cursor{0};
+    std::mutex delivering{};
+};
+
+}  // namespace cmdline
@@ -0,0 +1,3552 @@
+/// @file core.h
+/// @author Hideyuki Tanaka, moth (QianMoth@qq.com)
+/// @brief cmdline 的轻量核心
+/// @details
+/// 只依赖 `<string>`、`<vector>` 和少量C头文件，不引入 `<iostream>`、`<sstream>`、`<map>`，
+/// 也就没有 `<iostream>` 带来的静态初始化。
+/// 算术类型和 std::string 的转换、类型名在这里实现；其他类型基于流的转换和 typeid 类型名由 cmdline.h 提供，
+/// 使用帮助 usage() 和输出后退出程序的 parse_check() 定义在 usage.h 中。
+///
+/// @copyright Copyright (c) 2009, Hideyuki Tanaka
+///
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#ifdef CMDLINE_ENABLE_STATS
+#include <chrono>
+#include <functional>
+#endif
+
+namespace cmdline {
+
+/// @brief 不拥有内存的字符串视图，用于 flat_map 的键和值
+class string_ref
+{
+  public:
+    string_ref() = default;
+    string_ref(const char *data, std::size_t size) : ptr(data), len(size) {}
+    // 允许从字符串隐式转换，便于查找
+    string_ref(const char *s) : ptr(s), len(std::strlen(s)) {}              // NOLINT
+    string_ref(const std::string &s) : ptr(s.data()), len(s.size()) {}  // NOLINT
+
+    const char *data() const { return ptr; }
+    std::size_t size() const { return len; }
+    bool empty() const { return len == 0; }
+    const char *begin() const { return ptr; }
+    const char *end() const { return ptr + len; }
+
+    std::string str() const { return std::string(ptr, len); }
+
+    /// @brief 按字节比较
+    /// @return int 小于、等于、大于 other 时分别为负数、0、正数
+    int compare(string_ref other) const
+    {
+        std::size_t const n = len < other.len ? len : other.len;
+        int const r = n == 0 ? 0 : std::memcmp(ptr, other.ptr, n);
+        if (r != 0) {
+            return r;
+        }
+        return len < other.len ? -1 : (len > other.len ? 1 : 0);
+    }
+
+    friend bool operator==(string_ref a, string_ref b) { return a.len == b.len && a.compare(b) == 0; }
+    friend bool operator!=(string_ref a, string_ref b) { return !(a == b); }
+    friend bool operator<(string_ref a, string_ref b) { return a.compare(b) < 0; }
+
+  private:
+    const char *ptr{""};
+    std::size_t len{0};
+};
+
+namespace detail {
+
+/// @brief 是否为空白字符，与流提取跳过的字符一致
+inline bool is_space(char c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+/// @brief 是否按单个字符读写
+/// @tparam T
+template <class T>
+struct is_char
+{
+    static const bool value = std::is_same<T, char>::value || std::is_same<T, signed char>::value ||
+                              std::is_same<T, unsigned char>::value;
+};
+
+/// @brief 字符串与T之间的转换
+/// @details 这里只声明主模板，通用(基于流)的实现位于 cmdline.h
+/// @tparam T
+template <class T, class Enable = void>
+struct converter;
+
+/// @brief std::string 原样转换
+template <>
+struct converter<std::string>
+{
+    static bool from_string(const char *first, const char *last, std::string &out)
+    {
+        out.assign(first, last);
+        return true;
+    }
+
+    static std::string to_string(const std::string &v) { return v; }
+};
+
+/// @brief bool 与流的 noboolalpha 行为一致，只接受 0 和 1
+template <>
+struct converter<bool>
+{
+    static bool from_string(const char *first, const char *last, bool &out)
+    {
+        while (first != last && is_space(*first)) {
+            ++first;
+        }
+        if (first == last) {
+            return false;
+        }
+        bool value = false;
+        for (; first != last; ++first) {
+            if (*first != '0' && *first != '1') {
+                return false;
+            }
+            value = value || *first == '1';
+        }
+        out = value;
+        return true;
+    }
+
+    static std::string to_string(bool v) { return v ? "1" : "0"; }
+};
+
+/// @brief 字符类型按单个字符读写
+template <class T>
+struct converter<T, typename std::enable_if<is_char<T>::value>::type>
+{
+    static bool from_string(const char *first, const char *last, T &out)
+    {
+        while (first != last && is_space(*first)) {
+            ++first;
+        }
+        if (last - first != 1) {
+            return false;
+        }
+        out = static_cast<T>(*first);
+        return true;
+    }
+
+    static std::string to_string(T v) { return std::string(1, static_cast<char>(v)); }
+};
+
+/// @brief 整数，溢出和多余字符都视为失败
+template <class T>
+struct converter<T, typename std::enable_if<std::is_integral<T>::value && !is_char<T>::value &&
+                                            !std::is_same<T, bool>::value>::type>
+{
+    static bool from_string(const char *first, const char *last, T &out)
+    {
+        typedef typename std::make_unsigned<T>::type unsigned_type;
+
+        while (first != last && is_space(*first)) {
+            ++first;
+        }
+        bool neg = false;
+        if (first != last && (*first == '+' || *first == '-')) {
+            neg = *first == '-';
+            ++first;
+        }
+        if (first == last) {
+            return false;
+        }
+
+        // 与流提取一致：无符号类型的负数按补码回绕
+        unsigned_type limit = static_cast<unsigned_type>(std::numeric_limits<T>::max());
+        if (neg && std::is_signed<T>::value) {
+            limit = static_cast<unsigned_type>(limit + 1);
+        }
+
+        unsigned_type value = 0;
+        for (; first != last; ++first) {
+            unsigned const d = static_cast<unsigned char>(*first) - static_cast<unsigned>('0');
+            if (d > 9) {
+                return false;
+            }
+            if (value > limit / 10 || (value == limit / 10 && d > limit % 10)) {
+                return false;
+            }
+            value = static_cast<unsigned_type>(value * 10 + d);
+        }
+
+        out = static_cast<T>(neg ? static_cast<unsigned_type>(0 - value) : value);
+        return true;
+    }
+
+    static std::string to_string(T v)
+    {
+        char buf[32];
+        if (std::is_signed<T>::value) {
+            std::snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(v));
+        } else {
+            std::snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(v));
+        }
+        return buf;
+    }
+};
+
+inline float strto(const char *s, char **end, float * /*tag*/)
+{
+    return std::strtof(s, end);
+}
+
+inline double strto(const char *s, char **end, double * /*tag*/)
+{
+    return std::strtod(s, end);
+}
+
+inline long double strto(const char *s, char **end, long double * /*tag*/)
+{
+    return std::strtold(s, end);
+}
+
+/// @brief 是否是流能读取的十进制浮点数：可选的符号、数字和小数点、可选的指数
+/// @details strtod 还接受 inf、nan 和十六进制，流不接受，这里先排除
+inline bool is_decimal_float(const char *first, const char *last)
+{
+    while (first != last && is_space(*first)) {
+        ++first;
+    }
+    if (first != last && (*first == '+' || *first == '-')) {
+        ++first;
+    }
+    bool digits = false;
+    bool point = false;
+    for (; first != last; ++first) {
+        if (*first >= '0' && *first <= '9') {
+            digits = true;
+        } else if (*first == '.' && !point) {
+            point = true;
+        } else {
+            break;
+        }
+    }
+    if (!digits) {
+        return false;
+    }
+    if (first != last && (*first == 'e' || *first == 'E')) {
+        ++first;
+        if (first != last && (*first == '+' || *first == '-')) {
+            ++first;
+        }
+        if (first == last) {
+            return false;
+        }
+        for (; first != last && *first >= '0' && *first <= '9'; ++first) {
+        }
+    }
+    return first == last;
+}
+
+/// @brief 浮点数，只接受十进制形式(与流一致)，输出格式与流的默认格式(%g)一致
+template <class T>
+struct converter<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+    static bool from_string(const char *first, const char *last, T &out)
+    {
+        if (!is_decimal_float(first, last)) {
+            return false;
+        }
+        // strtod 需要以'\0'结尾，短字符串拷贝到栈上
+        std::size_t const len = static_cast<std::size_t>(last - first);
+        char buf[64];
+        std::string heap{};
+        char *s = buf;
+        if (len < sizeof(buf)) {
+            std::memcpy(buf, first, len);
+            buf[len] = '\0';
+        } else {
+            heap.assign(first, last);
+            s = &heap[0];
+        }
+
+        char *end = nullptr;
+        errno = 0;
+        T const value = strto(s, &end, static_cast<T *>(nullptr));
+        if (end == s || *end != '\0' || errno == ERANGE) {
+            return false;
+        }
+        out = value;
+        return true;
+    }
+
+    static std::string to_string(T v)
+    {
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "%Lg", static_cast<long double>(v));
+        return buf;
+    }
+};
+
+/// @brief 类型T在使用说明中显示的名称
+/// @details 这里只声明主模板，通用(基于 typeid)的实现位于 cmdline.h
+/// @tparam T
+template <class T, class Enable = void>
+struct type_name;
+
+#define CMDLINE_DEFINE_TYPE_NAME(type, text)        \
+    template <>                                     \
+    struct type_name<type>                          \
+    {                                               \
+        static std::string get() { return (text); } \
+    };
+
+CMDLINE_DEFINE_TYPE_NAME(std::string, "string")
+CMDLINE_DEFINE_TYPE_NAME(bool, "bool")
+CMDLINE_DEFINE_TYPE_NAME(char, "char")
+CMDLINE_DEFINE_TYPE_NAME(signed char, "signed char")
+CMDLINE_DEFINE_TYPE_NAME(unsigned char, "unsigned char")
+CMDLINE_DEFINE_TYPE_NAME(short, "short")
+CMDLINE_DEFINE_TYPE_NAME(unsigned short, "unsigned short")
+CMDLINE_DEFINE_TYPE_NAME(int, "int")
+CMDLINE_DEFINE_TYPE_NAME(unsigned int, "unsigned int")
+CMDLINE_DEFINE_TYPE_NAME(long, "long")
+CMDLINE_DEFINE_TYPE_NAME(unsigned long, "unsigned long")
+CMDLINE_DEFINE_TYPE_NAME(long long, "long long")
+CMDLINE_DEFINE_TYPE_NAME(unsigned long long, "unsigned long long")
+CMDLINE_DEFINE_TYPE_NAME(float, "float")
+CMDLINE_DEFINE_TYPE_NAME(double, "double")
+CMDLINE_DEFINE_TYPE_NAME(long double, "long double")
+CMDLINE_DEFINE_TYPE_NAME(string_ref, "string")
+
+#undef CMDLINE_DEFINE_TYPE_NAME
+
+template <class T>
+std::string readable_typename()
+{
+    return type_name<T>::get();
+}
+
+/// @brief 帮助信息中的默认值
+/// @param def
+/// @param width 最多显示的字符数，更长的截断后以 "..." 结尾；0 表示不限制
+template <class T>
+std::string default_value(const T &def, std::size_t width)
+{
+    std::string text = converter<T>::to_string(def);
+    if (width != 0 && text.size() > width) {
+        text.resize(width);
+        text += "...";
+    }
+    return text;
+}
+
+/// @brief 字符串只拷贝要显示的部分
+template <>
+inline std::string default_value<std::string>(const std::string &def, std::size_t width)
+{
+    if (width != 0 && def.size() > width) {
+        return def.substr(0, width) + "...";
+    }
+    return def;
+}
+
+/// @brief 选项中保存解析结果的对象的初值
+/// @details 能默认构造的类型不拷贝默认值，否则从默认值拷贝
+template <class T>
+typename std::enable_if<std::is_default_constructible<T>::value, T>::type initial_value(const T & /*def*/)
+{
+    return T();
+}
+
+template <class T>
+typename std::enable_if<!std::is_default_constructible<T>::value, T>::type initial_value(const T &def)
+{
+    return def;
+}
+
+/// @brief 以本机字节序追加一个64位整数
+inline void put_u64(std::string &out, std::uint64_t v)
+{
+    char buf[sizeof(v)];
+    std::memcpy(buf, &v, sizeof(v));
+    out.append(buf, sizeof(v));
+}
+
+/// @brief 追加长度和内容
+inline void put_bytes(std::string &out, const char *data, std::size_t size)
+{
+    put_u64(out, size);
+    out.append(data, size);
+}
+
+inline bool get_u64(const char *&p, const char *end, std::uint64_t &v)
+{
+    if (static_cast<std::size_t>(end - p) < sizeof(v)) {
+        return false;
+    }
+    std::memcpy(&v, p, sizeof(v));
+    p += sizeof(v);
+    return true;
+}
+
+/// @brief 读取长度和内容，data 指向输入缓冲区，不拷贝
+inline bool get_bytes(const char *&p, const char *end, const char *&data, std::size_t &size)
+{
+    std::uint64_t n = 0;
+    if (!get_u64(p, end, n) || static_cast<std::uint64_t>(end - p) < n) {
+        return false;
+    }
+    data = p;
+    size = static_cast<std::size_t>(n);
+    p += size;
+    return true;
+}
+
+/// @brief FNV-1a 哈希
+inline std::uint64_t fnv1a(const char *data, std::size_t size, std::uint64_t h = 14695981039346656037ULL)
+{
+    for (std::size_t i = 0; i < size; i++) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/// @brief converter<T> 能否从文本读取 T
+/// @details 只有自己的 reader、没有 operator>> 的类型不能编码
+template <class T, class Enable = void>
+struct has_from_string : std::false_type
+{
+};
+
+template <class T>
+struct has_from_string<T, decltype(void(converter<T>::from_string(static_cast<const char *>(nullptr),
+                                                                   static_cast<const char *>(nullptr),
+                                                                   std::declval<T &>())))> : std::true_type
+{
+};
+
+/// @brief 选项值的二进制编码
+/// @details 通用版本表示不能编码，含有这种值的解析结果 serialize() 失败，缓存和 handoff 回退到 parse()
+/// @tparam T
+template <class T, class Enable = void>
+struct codec
+{
+    static const bool supported = false;
+
+    static void save(const T & /*v*/, std::string & /*out*/) {}
+
+    static bool load(const char *& /*p*/, const char * /*end*/, T & /*v*/) { return false; }
+};
+
+/// @brief converter 能读取的类型借助 converter 保存为文本
+template <class T>
+struct codec<T, typename std::enable_if<!std::is_arithmetic<T>::value && has_from_string<T>::value>::type>
+{
+    static const bool supported = true;
+
+    static void save(const T &v, std::string &out)
+    {
+        std::string const text = converter<T>::to_string(v);
+        put_bytes(out, text.data(), text.size());
+    }
+
+    static bool load(const char *&p, const char *end, T &v)
+    {
+        const char *data = nullptr;
+        std::size_t size = 0;
+        return get_bytes(p, end, data, size) && converter<T>::from_string(data, data + size, v);
+    }
+};
+
+/// @brief 算术类型直接拷贝内存
+template <class T>
+struct codec<T, typename std::enable_if<std::is_arithmetic<T>::value>::type>
+{
+    static const bool supported = true;
+
+    static void save(const T &v, std::string &out)
+    {
+        char buf[sizeof(T)];
+        std::memcpy(buf, &v, sizeof(T));
+        out.append(buf, sizeof(T));
+    }
+
+    static bool load(const char *&p, const char *end, T &v)
+    {
+        if (static_cast<std::size_t>(end - p) < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&v, p, sizeof(T));
+        p += sizeof(T);
+        return true;
+    }
+};
+
+template <>
+struct codec<std::string>
+{
+    static const bool supported = true;
+
+    static void save(const std::string &v, std::string &out) { put_bytes(out, v.data(), v.size()); }
+
+    static bool load(const char *&p, const char *end, std::string &v)
+    {
+        const char *data = nullptr;
+        std::size_t size = 0;
+        if (!get_bytes(p, end, data, size)) {
+            return false;
+        }
+        v.assign(data, size);
+        return true;
+    }
+};
+
+/// @brief 视图保存为内容，读取后指向输入缓冲区，由 flat_map 拷贝到自己的存储中
+template <>
+struct codec<string_ref>
+{
+    static const bool supported = true;
+
+    static void save(const string_ref &v, std::string &out) { put_bytes(out, v.data(), v.size()); }
+
+    static bool load(const char *&p, const char *end, string_ref &v)
+    {
+        const char *data = nullptr;
+        std::size_t size = 0;
+        if (!get_bytes(p, end, data, size)) {
+            return false;
+        }
+        v = string_ref(data, size);
+        return true;
+    }
+};
+
+/// @brief 值中视图所占的字节数，只有 string_ref 不为0
+template <class T>
+std::size_t view_bytes(const T & /*v*/)
+{
+    return 0;
+}
+
+inline std::size_t view_bytes(const string_ref &v)
+{
+    return v.size();
+}
+
+/// @brief 把值中的视图拷贝到 dst 并指向拷贝
+template <class T>
+void rebase(T & /*v*/, char *& /*dst*/)
+{
+}
+
+inline void rebase(string_ref &v, char *&dst)
+{
+    if (!v.empty()) {
+        std::memcpy(dst, v.data(), v.size());
+    }
+    v = string_ref(dst, v.size());
+    dst += v.size();
+}
+
+/// @brief 自底向上的稳定归并排序，core.h 不引入 <algorithm>
+/// @param v
+/// @param less 严格弱序
+template <class T, class Less>
+void merge_sort(std::vector<T> &v, Less less)
+{
+    std::size_t const n = v.size();
+    std::vector<T> tmp(n);
+    for (std::size_t width = 1; width < n; width *= 2) {
+        for (std::size_t lo = 0; lo < n; lo += 2 * width) {
+            std::size_t const mid = lo + width < n ? lo + width : n;
+            std::size_t const hi = mid + width < n ? mid + width : n;
+            std::size_t i = lo;
+            std::size_t j = mid;
+            std::size_t k = lo;
+            while (i < mid && j < hi) {
+                tmp[k++] = less(v[j], v[i]) ? v[j++] : v[i++];
+            }
+            while (i < mid) {
+                tmp[k++] = v[i++];
+            }
+            while (j < hi) {
+                tmp[k++] = v[j++];
+            }
+        }
+        v.swap(tmp);
+    }
+}
+
+}  // namespace detail
+
+// ==================================================================
+// ==================================================================
+// ==================================================================
+// ==================================================================
+
+/// @brief 自定义错误类型 cli错误
+class cmdline_error : public std::exception
+{
+  public:
+    explicit cmdline_error(std::string msg) : msg(std::move(msg)) {}
+    ~cmdline_error() noexcept override = default;
+    const char *what() const noexcept override { return msg.c_str(); }
+
+  private:
+    std::string msg;
+};
+
+template <class T>
+struct default_reader
+{
+    T operator()(const std::string &str)
+    {
+        T ret;
+        if (!detail::converter<T>::from_string(str.data(), str.data() + str.size(), ret)) {
+            throw std::bad_cast();
+        }
+        return ret;
+    }
+};
+
+template <class T>
+struct range_reader
+{
+    range_reader(const T &low, const T &high) : low(low), high(high) {}
+    T operator()(const std::string &s) const
+    {
+        T ret = default_reader<T>()(s);
+        if (!contains(ret)) {
+            throw cmdline::cmdline_error("range_error");
+        }
+        return ret;
+    }
+    bool contains(const T &v) const { return v >= low && v <= high; }
+
+  private:
+    T low, high;
+};
+
+template <class T>
+range_reader<T> range(const T &low, const T &high)
+{
+    return range_reader<T>(low, high);
+}
+
+template <class T>
+struct oneof_reader
+{
+    T operator()(const std::string &s)
+    {
+        T ret = default_reader<T>()(s);
+        if (!contains(ret)) {
+            throw cmdline_error("");
+        }
+        return ret;
+    }
+    void add(const T &v) { alt.push_back(v); }
+    bool contains(const T &v) const
+    {
+        for (const auto &a : alt) {
+            if (a == v) {
+                return true;
+            }
+        }
+        return false;
+    }
+    const std::vector<T> &alternatives() const { return alt; }
+
+  private:
+    std::vector<T> alt;
+};
+
+#pragma region /* oneof_reader */
+
+template <class T>
+oneof_reader<T> oneof(T a1)
+{
+    oneof_reader<T> ret;
+    ret.add(a1);
+    return ret;
+}
+
+template <class T>
+oneof_reader<T> oneof(T a1, T a2)
+{
+    oneof_reader<T> ret;
+    ret.add(a1);
+    ret.add(a2);
+    return ret;
+}
+
+template <class T>
+oneof_reader<T> oneof(T a1, T a2, T a3)
+{
+    oneof_reader<T> ret;
+    ret.add(a1);
+    ret.add(a2);
+    ret.add(a3);
+    return ret;
+}
+
+template <class T>
+oneof_reader<T> oneof(T a1, T a2, T a3, T a4)
+{
+    oneof_reader<T> ret;
+    ret.add(a1);
+    ret.add(a2);
+    ret.add(a3);
+    ret.add(a4);
+    return ret;
+}
+
+template <class T>
+oneof_reader<T> oneof(T a1, T a2, T a3, T a4, T a5)
+{
+    oneof_reader<T> ret;
+    ret.add(a1);
+    ret.add(a2);
+    ret.add(a3);
+    ret.add(a4);
+    ret.add(a5);
+    return ret;
+}
+
+template <class T>
+oneof_reader<T> oneof(T a1, T a2, T a3, T a4, T a5, T a6)
+{
+    oneof_reader<T> ret;
+    ret.add(a1);
+    ret.add(a2);
+    ret.add(a3);
+    ret.add(a4);
+    ret.add(a5);
+    ret.add(a6);
+    return ret;
+}
+
+template <class T>
+oneof_reader<T> oneof(T a1, T a2, T a3, T a4, T a5, T a6, T a7)
+{
+    oneof_reader<T> ret;
+    ret.add(a1);
+    ret.add(a2);
+    ret.add(a3);
+    ret.add(a4);
+    ret.add(a5);
+    ret.add(a6);
+    ret.add(a7);
+    return ret;
+}
+
+template <class T>
+oneof_reader<T> oneof(T a1, T a2, T a3, T a4, T a5, T a6, T a7, T a8)
+{
+    oneof_reader<T> ret;
+    ret.add(a1);
+    ret.add(a2);
+    ret.add(a3);
+    ret.add(a4);
+    ret.add(a5);
+    ret.add(a6);
+    ret.add(a7);
+    ret.add(a8);
+    return ret;
+}
+
+template <class T>
+oneof_reader<T> oneof(T a1, T a2, T a3, T a4, T a5, T a6, T a7, T a8, T a9)
+{
+    oneof_reader<T> ret;
+    ret.add(a1);
+    ret.add(a2);
+    ret.add(a3);
+    ret.add(a4);
+    ret.add(a5);
+    ret.add(a6);
+    ret.add(a7);
+    ret.add(a8);
+    ret.add(a9);
+    return ret;
+}
+
+template <class T>
+oneof_reader<T> oneof(T a1, T a2, T a3, T a4, T a5, T a6, T a7, T a8, T a9, T a10)
+{
+    oneof_reader<T> ret;
+    ret.add(a1);
+    ret.add(a2);
+    ret.add(a3);
+    ret.add(a4);
+    ret.add(a5);
+    ret.add(a6);
+    ret.add(a7);
+    ret.add(a8);
+    ret.add(a9);
+    ret.add(a10);
+    return ret;
+}
+
+#pragma endregion /* oneof_reader */
+
+namespace detail {
+
+/// @brief reader 是否提供在视图上转换的 `bool read(const char *first, const char *last, T &out)`
+template <class F, class T>
+struct has_view_read
+{
+    template <class U>
+    static auto test(int) -> decltype(std::declval<U &>().read(static_cast<const char *>(nullptr),
+                                                               static_cast<const char *>(nullptr), std::declval<T &>()),
+                                      std::true_type());
+    template <class U>
+    static std::false_type test(...);
+
+    static constexpr bool value = decltype(test<F>(0))::value;
+};
+
+/// @brief 调用 reader 把 [first, last) 转换到 out
+/// @details 通用版本：reader 只接受 std::string，先拷贝到复用的 buf 中
+/// @return bool false-内容不合法，此时 out 不变
+template <class T, class F>
+typename std::enable_if<!has_view_read<F, T>::value, bool>::type read_value(F &reader, const char *first,
+                                                                             const char *last, std::string &buf,
+                                                                             T &out)
+{
+    buf.assign(first, last);
+    out = reader(buf);
+    return true;
+}
+
+/// @brief 提供 read() 的 reader 直接在视图上转换，例如 cmdline/units.h 中的 unit_reader
+template <class T, class F>
+typename std::enable_if<has_view_read<F, T>::value, bool>::type read_value(F &reader, const char *first,
+                                                                            const char *last, std::string & /*buf*/,
+                                                                            T &out)
+{
+    return reader.read(first, last, out);
+}
+
+/// @brief 内置 reader 直接在视图上转换，不构造临时字符串
+template <class T>
+bool read_value(default_reader<T> & /*reader*/, const char *first, const char *last, std::string & /*buf*/, T &out)
+{
+    return converter<T>::from_string(first, last, out);
+}
+
+template <class T>
+bool read_value(range_reader<T> &reader, const char *first, const char *last, std::string & /*buf*/, T &out)
+{
+    T value;
+    if (!converter<T>::from_string(first, last, value) || !reader.contains(value)) {
+        return false;
+    }
+    out = std::move(value);
+    return true;
+}
+
+template <class T>
+bool read_value(oneof_reader<T> &reader, const char *first, const char *last, std::string & /*buf*/, T &out)
+{
+    T value;
+    if (!converter<T>::from_string(first, last, value) || !reader.contains(value)) {
+        return false;
+    }
+    out = std::move(value);
+    return true;
+}
+
+/// @brief 视图直接指向参数，不拷贝
+inline bool read_value(default_reader<string_ref> & /*reader*/, const char *first, const char *last,
+                       std::string & /*buf*/, string_ref &out)
+{
+    out = string_ref(first, static_cast<std::size_t>(last - first));
+    return true;
+}
+
+inline bool read_value(oneof_reader<std::string> &reader, const char *first, const char *last, std::string & /*buf*/,
+                       std::string &out)
+{
+    std::size_t const len = static_cast<std::size_t>(last - first);
+    for (const auto &a : reader.alternatives()) {
+        if (a.compare(0, std::string::npos, first, len) == 0) {
+            out.assign(first, last);
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace detail
+
+// ==================================================================
+// ==================================================================
+// ==================================================================
+// ==================================================================
+
+/// @brief 选项句柄
+/// @details
+/// 保存选项的添加顺序和选项本身的地址，由 parser::flag() 获取，判断选项是否被设置时不需要查找。
+/// 使用时 parser 比较该位置上的选项是否就是句柄中的选项，默认构造的或者别的 parser 的句柄会被拒绝
+class flag_handle
+{
+  public:
+    flag_handle() = default;
+
+    /// @brief 选项的添加顺序
+    std::size_t index() const { return idx; }
+
+  protected:
+    friend class parser;
+    flag_handle(std::size_t idx, const void *option) : idx(idx), option(option) {}
+
+  private:
+    std::size_t idx{0};
+
+    /// @brief 句柄所属的选项，只用于校验
+    const void *option{nullptr};
+};
+
+/// @brief 有参数选项的句柄
+/// @details 由 parser::handle() 获取，类型在获取时检查一次，之后读取和取出都不需要查找；也可以当作 flag_handle 使用
+/// @tparam T 选项参数类型
+template <class T>
+class value_handle : public flag_handle
+{
+  public:
+    value_handle() = default;
+
+  private:
+    friend class parser;
+    value_handle(std::size_t idx, const void *option) : flag_handle(idx, option) {}
+};
+
+/// @brief 选项位图，按添加顺序每个选项一位
+/// @details 用于批量判断和保存、比较整个解析结果中被设置的选项
+class flag_set
+{
+  public:
+    void add(flag_handle h)
+    {
+        if (h.index() / 64 >= bits.size()) {
+            bits.resize(h.index() / 64 + 1, 0);
+        }
+        bits[h.index() / 64] |= std::uint64_t(1) << (h.index() % 64);
+    }
+
+    void remove(flag_handle h)
+    {
+        if (h.index() / 64 < bits.size()) {
+            bits[h.index() / 64] &= ~(std::uint64_t(1) << (h.index() % 64));
+        }
+    }
+
+    bool test(flag_handle h) const
+    {
+        return h.index() / 64 < bits.size() && ((bits[h.index() / 64] >> (h.index() % 64)) & 1);
+    }
+
+    void clear() { bits.clear(); }
+
+    /// @brief 是否有任意一位被设置
+    bool any() const
+    {
+        for (auto word : bits) {
+            if (word != 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// @brief 被设置的位数
+    std::size_t count() const
+    {
+        std::size_t n = 0;
+        for (auto word : bits) {
+            for (; word != 0; word &= word - 1) {
+                n++;
+            }
+        }
+        return n;
+    }
+
+    /// @brief 按字导出，第i个选项对应 words()[i / 64] 的第 i % 64 位
+    const std::vector<std::uint64_t> &words() const { return bits; }
+
+    /// @brief 比较两份位图，末尾多出的全零字不影响结果
+    bool operator==(const flag_set &other) const
+    {
+        std::size_t const n = bits.size() > other.bits.size() ? bits.size() : other.bits.size();
+        for (std::size_t w = 0; w < n; w++) {
+            std::uint64_t const a = w < bits.size() ? bits[w] : 0;
+            std::uint64_t const b = w < other.bits.size() ? other.bits[w] : 0;
+            if (a != b) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool operator!=(const flag_set &other) const { return !(*this == other); }
+
+  private:
+    friend class parser;
+    std::vector<std::uint64_t> bits{};
+};
+
+#ifdef CMDLINE_ENABLE_STATS
+
+/// @brief 某个阶段的执行次数和累计耗时
+struct phase_stats
+{
+    phase_stats() = default;
+    phase_stats(std::uint64_t count, std::uint64_t ns) : count(count), ns(ns) {}
+
+    std::uint64_t count{0};
+    std::uint64_t ns{0};
+
+    phase_stats &operator+=(const phase_stats &other)
+    {
+        count += other.count;
+        ns += other.ns;
+        return *this;
+    }
+};
+
+/// @brief 单个选项的 reader 调用统计
+struct option_stats
+{
+    std::string name;
+    phase_stats reader;
+};
+
+/// @brief 解析统计
+/// @details parser::stats() 返回累计值；统计回调收到的是刚结束的那一次解析
+struct parse_stats
+{
+    /// @brief 解析次数
+    std::uint64_t parses{0};
+    /// @brief 最近一次解析开始的时间，steady_clock 纳秒
+    std::uint64_t begin_ns{0};
+    /// @brief 解析期间的内存分配次数，需要先 set_allocation_counter()
+    std::uint64_t allocations{0};
+
+    phase_stats registration;
+    phase_stats tokenize;
+    phase_stats total;
+    phase_stats reset;
+    phase_stats short_table;
+    phase_stats long_lookup;
+    phase_stats reader;
+    phase_stats required;
+
+    /// @brief 每个选项的 reader 调用，按添加顺序，只包含调用过的选项
+    std::vector<option_stats> options;
+
+    /// @brief 累加另一份统计的计数部分
+    void accumulate(const parse_stats &other)
+    {
+        parses += other.parses;
+        begin_ns = other.begin_ns;
+        allocations += other.allocations;
+        registration += other.registration;
+        tokenize += other.tokenize;
+        total += other.total;
+        reset += other.reset;
+        short_table += other.short_table;
+        long_lookup += other.long_lookup;
+        reader += other.reader;
+        required += other.required;
+    }
+};
+
+namespace detail {
+
+typedef std::uint64_t (*allocation_counter_fn)();
+
+inline allocation_counter_fn &allocation_counter()
+{
+    static allocation_counter_fn counter = nullptr;
+    return counter;
+}
+
+inline std::uint64_t allocations()
+{
+    allocation_counter_fn const counter = allocation_counter();
+    return counter ? counter() : 0;
+}
+
+inline std::uint64_t now_ns()
+{
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+}
+
+/// @brief 作用域计时，析构时累加到一个或两个阶段上
+class phase_timer
+{
+  public:
+    explicit phase_timer(phase_stats &a, phase_stats *b = nullptr) : a(a), b(b), begin(now_ns()) {}
+    phase_timer(const phase_timer &) = delete;
+    phase_timer &operator=(const phase_timer &) = delete;
+    ~phase_timer()
+    {
+        phase_stats const delta{1, now_ns() - begin};
+        a += delta;
+        if (b != nullptr) {
+            *b += delta;
+        }
+    }
+
+  private:
+    phase_stats &a;
+    phase_stats *b;
+    std::uint64_t begin;
+};
+
+}  // namespace detail
+
+/// @brief 设置统计内存分配次数所用的计数器
+/// @details 计数器通常来自应用自己替换的 operator new 或 malloc 钩子，返回到目前为止的分配总次数
+/// @param counter 为nullptr时不统计
+inline void set_allocation_counter(std::uint64_t (*counter)())
+{
+    detail::allocation_counter() = counter;
+}
+
+#define CMDLINE_STATS(...) __VA_ARGS__
+#else
+#define CMDLINE_STATS(...)
+#endif
+
+/// @brief 按键排序、连续存放的映射，由 parser::add_map() 的选项收集
+/// @details
+/// 键是指向参数的视图：parse(argc, argv) 时指向 argv，parse(const std::string &) 时指向解析器的分词缓冲区，
+/// deserialize() 后指向映射自己的存储。使用映射期间传给 parse() 的参数必须保持有效(main 的 argv 总是满足)，
+/// 下一次解析后映射的内容随之改变。值类型为 string_ref 时值同样是视图。
+/// @tparam V 值类型
+template <class V>
+class flat_map
+{
+  public:
+    typedef std::pair<string_ref, V> value_type;
+    typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+    /// @brief 查找
+    /// @param key
+    /// @return const V* 不存在时为nullptr
+    const V *find(string_ref key) const
+    {
+        std::size_t const pos = lower_bound(key);
+        return pos < entries.size() && entries[pos].first == key ? &entries[pos].second : nullptr;
+    }
+
+    /// @brief 是否包含键
+    bool contains(string_ref key) const { return find(key) != nullptr; }
+
+    /// @brief 获取值，不存在时为 def
+    const V &get(string_ref key, const V &def) const
+    {
+        const V *v = find(key);
+        return v != nullptr ? *v : def;
+    }
+
+    /// @brief 获取值，不存在时抛出 cmdline_error
+    const V &at(string_ref key) const
+    {
+        const V *v = find(key);
+        if (v == nullptr) {
+            throw cmdline_error("there is no key: " + key.str());
+        }
+        return *v;
+    }
+
+    std::size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+    /// @brief 按键的顺序遍历
+    const_iterator begin() const { return entries.begin(); }
+    const_iterator end() const { return entries.end(); }
+
+  private:
+    friend class parser;
+
+    /// @brief 第一个不小于 key 的位置
+    std::size_t lower_bound(string_ref key) const
+    {
+        std::size_t lo = 0;
+        std::size_t hi = entries.size();
+        while (lo < hi) {
+            std::size_t const mid = lo + (hi - lo) / 2;
+            if (entries[mid].first < key) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    std::vector<value_type> entries{};
+};
+
+/// @brief 位置参数的个数
+enum class arity
+{
+    /// @brief 必须提供一个
+    single,
+    /// @brief 可以省略，省略时为默认值
+    optional,
+    /// @brief 剩余的所有参数，可以为空
+    variadic
+};
+
+/// @brief 描述表中选项的类型，见 parser::add_table()
+enum class option_kind
+{
+    /// @brief 无参数选项
+    flag,
+    /// @brief bool
+    boolean,
+    /// @brief int
+    integer,
+    /// @brief long long
+    int64,
+    /// @brief double
+    real,
+    /// @brief std::string
+    string
+};
+
+/// @brief 描述表中的一项，只含字面量，可以放在 constexpr 数组中
+/// @code
+/// ```cpp
+/// constexpr cmdline::option_def options[] = {
+///     {"host", 'h', "host name", cmdline::option_kind::string, true, nullptr},
+///     {"port", 'p', "port number", cmdline::option_kind::integer, false, "80"},
+///     {"verbose", 'v', "verbose output", cmdline::option_kind::flag, false, nullptr},
+/// };
+/// parser.add_table(options);
+/// ```
+/// @endcode
+struct option_def
+{
+    /// @brief 选项名，不能为空
+    const char *name;
+    /// @brief 选项缩写，0 表示没有
+    char short_name;
+    /// @brief 选项描述，可以为 nullptr
+    const char *desc;
+    option_kind kind;
+    /// @brief 是否必须，flag 忽略
+    bool need;
+    /// @brief 默认值的文本，注册时转换；nullptr 表示类型的默认值，flag 忽略
+    const char *def;
+};
+
+/// @brief 执行一批相互独立的任务，用于并行调用 reader，见 parser::set_executor()
+/// @details cmdline/parallel.h 中的 thread_pool 是一个实现
+class executor
+{
+  public:
+    virtual ~executor() = default;
+
+    /// @brief 对 [0, n) 中的每个 i 调用一次 task(context, i)，全部完成后返回
+    /// @param n
+    /// @param task 可以在任意线程上并发调用
+    /// @param context
+    virtual void run(std::size_t n, void (*task)(void *context, std::size_t i), void *context) = 0;
+};
+
+/// @brief 命令行解析器
+/// @details
+/// 稳态零分配：解析器内部的缓冲区(分词结果、argv、rest()、reader 的字符串缓冲区)在多次解析之间复用。
+/// 选项只使用 default_reader、range、oneof 时，第一次解析之后，再解析相同形状(参数个数相同，
+/// 每个参数不比之前长)且没有错误的输入不会分配内存。自定义 reader 按值返回结果，是否分配取决于它自己。
+///
+/// 定义 `CMDLINE_ENABLE_STATS` 后解析器会统计各阶段的次数和耗时，见 stats()。
+/// 这个宏会改变 parser 的布局，必须对整个程序统一定义。默认不定义，统计代码完全不参与编译。
+class parser
+{
+  public:
+    parser() = default;
+    parser(const parser &) = delete;
+    parser &operator=(const parser &) = delete;
+
+    ~parser()
+    {
+        // 析构所有选项
+        for (auto *option : ordered) {
+            delete option;
+        }
+        for (auto *arg : positionals) {
+            delete arg;
+        }
+    }
+
+    /// @brief 新建无参选项并添加
+    /// @param name 选项名
+    /// @param short_name 选项名缩写
+    /// @param desc 选项描述
+    /// @code
+    /// ```cpp
+    /// parser.add("help", 'h', "print this message");
+    /// ```
+    /// @endcode
+    void add(const std::string &name, char short_name = 0, const std::string &desc = "")
+    {
+        // 判断选项是否已经存在
+        std::size_t const pos = lower_bound(name.data(), name.size());
+        if (pos < index.size() && index[pos]->name() == name) {
+            // 名称重复定义
+            throw cmdline_error("multiple definition: " + name);
+        }
+        insert(pos, new option_without_value(name, short_name, desc));
+    }
+
+    /// @brief 添加选项
+    /// @tparam T 选项参数类型
+    /// @param name 选项名
+    /// @param short_name 选项缩写
+    /// @param desc 选项描述
+    /// @param need 是否必须
+    /// @param def 默认值
+    template <class T>
+    void add(const std::string &name, char short_name = 0, const std::string &desc = "", bool need = true,
+             T def = T())
+    {
+        add(name, short_name, desc, need, std::move(def), default_reader<T>());
+    }
+
+    /// @brief 新建选项并添加
+    /// @details 默认值和 reader 按值传入后移动到选项中，传入右值时不拷贝
+    /// @tparam T 选项参数类型
+    /// @tparam F
+    /// @param name 选项名
+    /// @param short_name 选项缩写
+    /// @param desc 选项描述
+    /// @param need 是否必须
+    /// @param def 默认值
+    /// @param reader
+    template <class T, class F>
+    void add(const std::string &name, char short_name = 0, const std::string &desc = "", bool need = true,
+             T def = T(), F reader = F())
+    {
+        static_assert(!std::is_same<T, string_ref>::value,
+                      "string_ref values are only supported by add_map(); use std::string for options");
+        // 判断选项是否已经存在
+        std::size_t const pos = lower_bound(name.data(), name.size());
+        if (pos < index.size() && index[pos]->name() == name) {
+            // 名称重复定义
+            throw cmdline_error("multiple definition: " + name);
+        }
+        // 将选项添加到索引中
+        insert(pos, new option_with_value_with_reader<T, F>(name, short_name, need, std::move(def), desc,
+                                                            std::move(reader)));
+    }
+
+    /// @brief 添加键值对选项
+    /// @details
+    /// 选项可以重复出现，每次的值是 `k=v` 或逗号分隔的 `k1=v1,k2=v2`，全部收集到一个按键排序的 flat_map 中，
+    /// 同一个键以最后一次为准。值用 reader 转换；V 为 string_ref 时键和值都是指向参数的视图，不拷贝。
+    /// 某次出现中有一项不合法时这次出现整体不合并，之前出现的内容保持不变。
+    /// string_ref 只能用作这里的值类型，add() 和 add_positional() 不支持。
+    /// @tparam V 值类型
+    /// @param name 选项名
+    /// @param short_name 选项缩写
+    /// @param desc 选项描述
+    template <class V>
+    void add_map(const std::string &name, char short_name = 0, const std::string &desc = "")
+    {
+        add_map<V>(name, short_name, desc, default_reader<V>());
+    }
+
+    /// @brief 添加键值对选项
+    /// @tparam V 值类型
+    /// @tparam F
+    /// @param name 选项名
+    /// @param short_name 选项缩写
+    /// @param desc 选项描述
+    /// @param reader 转换每个值
+    template <class V, class F>
+    void add_map(const std::string &name, char short_name, const std::string &desc, F reader)
+    {
+        std::size_t const pos = lower_bound(name.data(), name.size());
+        if (pos < index.size() && index[pos]->name() == name) {
+            throw cmdline_error("multiple definition: " + name);
+        }
+        insert(pos, new option_map_with_reader<V, F>(name, short_name, desc, std::move(reader)));
+    }
+
+    /// @brief 按描述表批量添加选项
+    /// @details
+    /// 先一次性预留存储并创建全部选项，再把新选项按名称排序一次，与已有索引归并时检查重名，
+    /// 用一张256项的表检查缩写重复，最后整体替换索引。逐个 add() 时每次插入都要移动索引，
+    /// 选项很多时是平方级的。任何一项出错都抛出 cmdline_error，解析器保持不变。
+    /// 与 add() 不同，缩写与已有选项或表中其他项重复也是错误。
+    /// @param table 描述表
+    /// @param n 项数
+    void add_table(const option_def *table, std::size_t n)
+    {
+        CMDLINE_STATS(detail::phase_timer const timer(total_stats.registration);)
+        std::vector<option_base *> made;
+        std::vector<option_base *> merged;
+        made.reserve(n);
+        try {
+            for (std::size_t i = 0; i < n; i++) {
+                made.push_back(make_option(table[i]));
+            }
+
+            std::vector<option_base *> sorted(made);
+            detail::merge_sort(sorted,
+                               [](const option_base *a, const option_base *b) { return a->name() < b->name(); });
+            // 归并到已有索引，重名的选项在归并结果中相邻
+            merged.reserve(index.size() + n);
+            std::size_t i = 0;
+            std::size_t j = 0;
+            while (i < index.size() || j < sorted.size()) {
+                option_base *const next =
+                    j == sorted.size() || (i < index.size() && index[i]->name() < sorted[j]->name()) ? index[i++]
+                                                                                                     : sorted[j++];
+                if (!merged.empty() && merged.back()->name() == next->name()) {
+                    throw cmdline_error("multiple definition: " + next->name());
+                }
+                merged.push_back(next);
+            }
+
+            bool taken[256] = {};
+            for (auto *option : ordered) {
+                taken[static_cast<unsigned char>(option->short_name())] = true;
+            }
+            for (auto *option : made) {
+                char const initial = option->short_name();
+                if (!initial) {
+                    continue;
+                }
+                if (taken[static_cast<unsigned char>(initial)]) {
+                    throw cmdline_error(std::string("multiple definition: -") + initial);
+                }
+                taken[static_cast<unsigned char>(initial)] = true;
+            }
+        } catch (...) {
+            for (auto *option : made) {
+                delete option;
+            }
+            throw;
+        }
+
+        ordered.reserve(ordered.size() + n);
+        std::size_t const words = (ordered.size() + n + 63) / 64;
+        if (words > set_bits.size()) {
+            set_bits.resize(words, 0);
+            required_bits.resize(words, 0);
+        }
+        for (auto *option : made) {
+            option->index = ordered.size();
+            if (option->must()) {
+                required_bits[option->index / 64] |= std::uint64_t(1) << (option->index % 64);
+            }
+            ordered.push_back(option);
+        }
+        index.swap(merged);
+        short_dirty = true;
+        spec_dirty = true;
+        clear_cache();
+    }
+
+    /// @brief 按描述表批量添加选项
+    /// @param table 描述表，可以是 constexpr 数组
+    template <std::size_t N>
+    void add_table(const option_def (&table)[N])
+    {
+        add_table(table, N);
+    }
+
+    /// @brief 添加位置参数
+    /// @tparam T 参数类型
+    /// @param name 参数名，只用于使用说明、错误信息和读取
+    /// @param desc 描述
+    /// @param count 必填的参数在前，可省略的在后，剩余参数最多一个且在最后
+    /// @param def 省略时的值
+    template <class T>
+    void add_positional(const std::string &name, const std::string &desc = "", arity count = arity::single,
+                        T def = T())
+    {
+        add_positional(name, desc, count, std::move(def), default_reader<T>());
+    }
+
+    /// @brief 添加位置参数
+    /// @details
+    /// 不是选项的参数按顺序绑定到位置参数上，在解析时用与选项相同的方式转换；绑定不了的参数仍进入 rest()。
+    /// 剩余参数直接转换到一个复用的 std::vector<T> 中，不经过字符串数组。
+    /// @tparam T 参数类型
+    /// @tparam F
+    /// @param name 参数名，只用于使用说明、错误信息和读取
+    /// @param desc 描述
+    /// @param count 必填的参数在前，可省略的在后，剩余参数最多一个且在最后
+    /// @param def 省略时的值
+    /// @param reader
+    template <class T, class F>
+    void add_positional(const std::string &name, const std::string &desc, arity count, T def, F reader)
+    {
+        static_assert(!std::is_same<T, string_ref>::value,
+                      "string_ref values are only supported by add_map(); use std::string for positional arguments");
+        if (find_positional(name) != nullptr) {
+            throw cmdline_error("multiple definition: " + name);
+        }
+        if (!positionals.empty()) {
+            arity const last = positionals.back()->count();
+            if (last == arity::variadic) {
+                throw cmdline_error("positional argument after variadic one: " + name);
+            }
+            if (last == arity::optional && count == arity::single) {
+                throw cmdline_error("required positional argument after optional one: " + name);
+            }
+        }
+        positionals.push_back(new positional_with_reader<T, F>(name, desc, count, std::move(def), std::move(reader)));
+        spec_dirty = true;
+        clear_cache();
+    }
+
+    /// @brief 在使用提示后面追加
+    /// @param[in] f
+    void footer(const std::string &f) { ftr = f; }
+
+    /// @brief 设置展示出来的可执行程序的名称
+    /// @details 如果不设置则展示完整的程序路径
+    /// @param[in] name
+    void set_program_name(const std::string &name) { prog_name = name; }
+
+    /// @brief 设置使用帮助中默认值最多显示的字符数
+    /// @details 更长的默认值截断后以 "..." 结尾。默认为0，完整显示
+    /// @param[in] width
+    void set_default_width(std::size_t width) { default_width = width; }
+
+    /// @brief 判断是否存在某个选项
+    /// @param[in] name 选项名称
+    /// @return true 存在
+    /// @return false 不存在
+    bool exist(const std::string &name) const
+    {
+        const option_base *p = find(name.data(), name.size());
+        if (p == nullptr) {
+            throw cmdline_error("there is no flag: --" + name);
+        }
+        return test(p->index);
+    }
+
+    /// @brief 通过句柄判断选项是否被设置，O(1)
+    /// @param[in] h flag() 返回的句柄
+    /// @return bool
+    bool exist(flag_handle h) const { return test(handle_index(h)); }
+
+    /// @brief 获取选项的句柄，之后可以不经查找直接判断选项是否被设置
+    /// @param[in] name 选项名称，有参数的选项也可以
+    /// @return flag_handle
+    flag_handle flag(const std::string &name) const
+    {
+        const option_base *p = find(name.data(), name.size());
+        if (p == nullptr) {
+            throw cmdline_error("there is no flag: --" + name);
+        }
+        return flag_handle(p->index, p);
+    }
+
+    /// @brief 由一组选项名构造位图
+    /// @param[in] names
+    /// @return flag_set
+    flag_set mask(const std::vector<std::string> &names) const
+    {
+        flag_set ret;
+        for (const auto &name : names) {
+            ret.add(flag(name));
+        }
+        return ret;
+    }
+
+    /// @brief mask 中是否有任意一个选项被设置
+    /// @param[in] m
+    /// @return bool
+    bool any(const flag_set &m) const
+    {
+        std::size_t const n = m.bits.size() < set_bits.size() ? m.bits.size() : set_bits.size();
+        for (std::size_t w = 0; w < n; w++) {
+            if ((m.bits[w] & set_bits[w]) != 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// @brief mask 中的选项是否全部被设置
+    /// @param[in] m
+    /// @return bool
+    bool all(const flag_set &m) const
+    {
+        for (std::size_t w = 0; w < m.bits.size(); w++) {
+            std::uint64_t const have = w < set_bits.size() ? set_bits[w] : 0;
+            if ((m.bits[w] & ~have) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// @brief 导出所有被设置的选项
+    /// @return flag_set 可以保存下来与之后的解析结果比较
+    flag_set flags() const
+    {
+        flag_set ret;
+        flags(ret);
+        return ret;
+    }
+
+    /// @brief 导出所有被设置的选项到 out，复用 out 的空间
+    /// @param[out] out
+    void flags(flag_set &out) const { out.bits.assign(set_bits.begin(), set_bits.end()); }
+
+    /// @brief 设置 name 时 names 中的选项也必须全部设置
+    /// @details
+    /// 约束在添加时编译为选项位图中的若干个字，解析结束时按字与 set_bits 做与、或运算，
+    /// 开销与约束涉及的字数成正比，与选项总数无关。选项必须已经添加。
+    /// @param name
+    /// @param names
+    /// @code
+    /// ```cpp
+    /// parser.depends_on("tls-cert", {"tls-key"});
+    /// ```
+    /// @endcode
+    void depends_on(const std::string &name, const std::vector<std::string> &names)
+    {
+        add_constraint(constraint_kind::depends, flag(name).index(), names);
+    }
+
+    /// @brief 设置 name 时 names 中的选项都不能设置
+    /// @param name
+    /// @param names
+    void conflicts_with(const std::string &name, const std::vector<std::string> &names)
+    {
+        add_constraint(constraint_kind::conflicts, flag(name).index(), names);
+    }
+
+    /// @brief names 中的选项必须恰好设置一个
+    /// @param names
+    void exactly_one_of(const std::vector<std::string> &names)
+    {
+        add_constraint(constraint_kind::exactly_one, 0, names);
+    }
+
+    /// @brief 根据选项名称获取参数
+    /// @tparam T
+    /// @param[in] name 选项名称
+    /// @return const T&
+    template <class T>
+    const T &get(const std::string &name) const
+    {
+        return typed_option<T>(name)->get();
+    }
+
+    /// @brief 获取有参数选项的句柄，之后读取和取出都不需要查找
+    /// @tparam T
+    /// @param[in] name 选项名称
+    /// @return value_handle<T>
+    template <class T>
+    value_handle<T> handle(const std::string &name) const
+    {
+        option_with_value<T> *p = typed_option<T>(name);
+        return value_handle<T>(p->index, p);
+    }
+
+    /// @brief 通过句柄获取参数
+    /// @tparam T
+    /// @param[in] h
+    /// @return const T&
+    template <class T>
+    const T &get(value_handle<T> h) const
+    {
+        return handle_option(h)->get();
+    }
+
+    /// @brief 解析结束后把选项的值移出，不拷贝
+    /// @details 之后 get() 返回默认值，直到下一次解析。没有设置过的选项返回默认值的拷贝
+    /// @tparam T
+    /// @param[in] name 选项名称
+    /// @return T
+    template <class T>
+    T take(const std::string &name)
+    {
+        return typed_option<T>(name)->take();
+    }
+
+    /// @brief 通过句柄把选项的值移出
+    /// @tparam T
+    /// @param[in] h
+    /// @return T
+    template <class T>
+    T take(value_handle<T> h)
+    {
+        return handle_option(h)->take();
+    }
+
+    /// @brief
+    /// @return const std::vector<std::string>&
+    const std::vector<std::string> &rest() const { return others; }
+
+    /// @brief 解析字符串
+    /// @param[in] arg
+    /// @return true
+    /// @return false
+    bool parse(const std::string &arg)
+    {
+        CMDLINE_STATS(begin_stats();)
+
+        bool ok = false;
+        if (cache_capacity != 0) {
+            cache_key.assign(1, 's');
+            cache_key += arg;
+            if (cache_lookup(ok)) {
+                CMDLINE_STATS(end_stats();)
+                return ok;
+            }
+        }
+
+        std::size_t argc = 0;
+        const char *error = nullptr;
+        {
+            CMDLINE_STATS(detail::phase_timer const timer(current_stats.tokenize);)
+            error = tokenize(arg, argc);
+        }
+        if (error == nullptr) {
+            argv_buf.clear();
+            for (std::size_t i = 0; i < argc; i++) {
+                argv_buf.push_back(tokens[i].c_str());
+            }
+            ok = parse_args(static_cast<int>(argc), argv_buf.data());
+            cache_store();
+        } else {
+            ok = abort_parse(error);
+        }
+
+        CMDLINE_STATS(end_stats();)
+        return ok;
+    }
+
+    /// @brief 根据参数列表进行解析
+    /// @param args 参数列表
+    /// @return true 解析正常
+    /// @return false 解析失败
+    bool parse(const std::vector<std::string> &args)
+    {
+        argv_buf.clear();
+        for (const auto &arg : args) {
+            argv_buf.push_back(arg.c_str());
+        }
+
+        return parse(static_cast<int>(argv_buf.size()), argv_buf.data());
+    }
+
+    /// @brief 根据命令行输入的内容进行解析
+    /// @param argc 参数个数
+    /// @param argv 参数内容
+    /// @return true 解析正常
+    /// @return false 解析失败
+    bool parse(int argc, const char *const argv[])
+    {
+        CMDLINE_STATS(begin_stats();)
+
+        bool ok = false;
+        if (cache_capacity != 0) {
+            // 每个参数连同结尾的'\0'作为键，与字符串输入区分开
+            cache_key.assign(1, 'a');
+            for (int i = 0; i < argc; i++) {
+                cache_key.append(argv[i], strlen(argv[i]) + 1);
+            }
+        }
+        if (cache_capacity == 0 || !cache_lookup(ok)) {
+            ok = parse_args(argc, argv);
+            cache_store();
+        }
+
+        CMDLINE_STATS(end_stats();)
+        return ok;
+    }
+
+    /// @brief 开启解析缓存
+    /// @details
+    /// 以原始输入(字符串或 argv)为键保存最近的解析结果，重复的输入直接恢复选项状态和 rest()，
+    /// 不再分词、查找和转换。容量满时淘汰最久没有使用的结果。查找是对哈希值的线性扫描，容量适合在几百以内。
+    /// 有副作用的 reader 用 no_cache() 排除。添加选项会清空缓存。
+    /// @param capacity 最多保存的结果数，为0时关闭缓存
+    void enable_cache(std::size_t capacity)
+    {
+        cache_capacity = capacity;
+        clear_cache();
+    }
+
+    /// @brief 清空缓存的结果，不影响命中计数
+    void clear_cache()
+    {
+        cache_entries.clear();
+        cache_hashes.clear();
+    }
+
+    /// @brief 设置了这个选项的解析结果不进入缓存，每次都会调用它的 reader
+    /// @param name
+    void no_cache(const std::string &name)
+    {
+        option_base *p = find(name.data(), name.size());
+        if (p == nullptr) {
+            throw cmdline_error("there is no flag: --" + name);
+        }
+        p->uncacheable = true;
+        clear_cache();
+    }
+
+    /// @brief 获取键值对选项收集到的映射
+    /// @tparam V
+    /// @param name
+    /// @return const flat_map<V>& 下一次解析前有效
+    template <class V>
+    const flat_map<V> &get_map(const std::string &name) const
+    {
+        const option_base *base = find(name.data(), name.size());
+        if (base == nullptr) {
+            throw cmdline_error("there is no flag: --" + name);
+        }
+        const option_map<V> *p = dynamic_cast<const option_map<V> *>(base);
+        if (p == nullptr) {
+            throw cmdline_error("type mismatch flag '" + name + "'");
+        }
+        return p->get();
+    }
+
+    /// @brief 获取单个或可省略的位置参数，省略时为默认值
+    /// @tparam T
+    /// @param name
+    /// @return const T&
+    template <class T>
+    const T &get_positional(const std::string &name) const
+    {
+        return typed_positional<T>(name)->get();
+    }
+
+    /// @brief 获取剩余参数
+    /// @tparam T
+    /// @param name
+    /// @return const std::vector<T>& 下一次解析前有效
+    template <class T>
+    const std::vector<T> &get_variadic(const std::string &name) const
+    {
+        return typed_positional<T>(name)->values();
+    }
+
+    /// @brief 把剩余参数移出，不拷贝，之后 get_variadic() 为空
+    /// @tparam T
+    /// @param name
+    /// @return std::vector<T>
+    template <class T>
+    std::vector<T> take_variadic(const std::string &name)
+    {
+        return const_cast<positional_with_value<T> *>(typed_positional<T>(name))->take();
+    }
+
+    /// @brief 位置参数实际得到的值的个数
+    /// @param name
+    /// @return std::size_t
+    std::size_t positional_count(const std::string &name) const
+    {
+        const positional_base *p = find_positional(name);
+        if (p == nullptr) {
+            throw cmdline_error("there is no argument: " + name);
+        }
+        return p->size();
+    }
+
+    /// @brief 设置执行 independent() 选项的 reader 的执行器
+    /// @param e 不接管所有权，为nullptr时所有 reader 都在解析线程中依次调用
+    void set_executor(executor *e) { exec = e; }
+
+    /// @brief 把选项的 reader 标记为独立的
+    /// @details
+    /// 设置了执行器时，独立的 reader 不在扫描参数时调用，而是在扫描结束后按选项分组交给执行器并发执行，
+    /// 解析耗时接近最慢的那个 reader 而不是所有 reader 之和。同一个选项出现多次时仍按出现顺序依次调用。
+    /// 结果和错误信息按参数顺序合并，与依次调用时相同。reader 不能访问其他选项或共享的可变状态。
+    /// 与依次调用时一样，reader 抛出的 std::exception 视为参数无效，其他异常在解析线程中从 parse() 重新抛出。
+    /// @param name
+    void independent(const std::string &name)
+    {
+        option_base *p = find(name.data(), name.size());
+        if (p == nullptr) {
+            throw cmdline_error("there is no flag: --" + name);
+        }
+        p->independent = true;
+    }
+
+    /// @brief 缓存命中次数
+    std::uint64_t cache_hits() const { return cache_hit_count; }
+
+    /// @brief 缓存未命中次数
+    std::uint64_t cache_misses() const { return cache_miss_count; }
+
+    /// @brief 解析，出错或指定了 --help 时输出使用帮助并退出程序
+    /// @details 与 usage() 一样定义在 cmdline/usage.h 中，调用它的翻译单元需要包含该头文件
+    /// @param arg
+    void parse_check(const std::string &arg);
+
+    /// @brief 解析参数列表，出错或指定了 --help 时输出使用帮助并退出程序
+    /// @param args
+    void parse_check(const std::vector<std::string> &args);
+
+    /// @brief 解析命令行，出错或指定了 --help 时输出使用帮助并退出程序
+    /// @param argc 参数个数
+    /// @param argv
+    void parse_check(int argc, char *argv[]);
+
+    /// @brief 选项定义的指纹
+    /// @details 由每个选项的名称、缩写、类型、是否必填以及位置参数按添加顺序计算，添加选项后改变
+    /// @return std::uint64_t
+    std::uint64_t fingerprint() const
+    {
+        if (spec_dirty) {
+            std::uint64_t h = detail::fnv1a(nullptr, 0);
+            for (auto *option : ordered) {
+                std::string const type = option->short_description();
+                char const flags[] = {option->short_name(), static_cast<char>(option->must()),
+                                      static_cast<char>(option->has_value())};
+                h = detail::fnv1a(option->name().c_str(), option->name().size() + 1, h);
+                h = detail::fnv1a(flags, sizeof(flags), h);
+                h = detail::fnv1a(type.c_str(), type.size() + 1, h);
+            }
+            for (auto *arg : positionals) {
+                std::string const type = arg->type_name();
+                char const count = static_cast<char>(arg->count());
+                h = detail::fnv1a(arg->name().c_str(), arg->name().size() + 1, h);
+                h = detail::fnv1a(&count, 1, h);
+                h = detail::fnv1a(type.c_str(), type.size() + 1, h);
+            }
+            spec_hash = h;
+            spec_dirty = false;
+        }
+        return spec_hash;
+    }
+
+    /// @brief 把解析结果编码为二进制
+    /// @details
+    /// 包含被设置的选项及其值、位置参数、rest() 和错误信息，以选项定义的指纹为键。
+    /// 算术类型和 std::string 直接拷贝，converter 能读取的其他类型保存为文本。编码使用本机字节序，
+    /// 用于交给同一程序的子进程，见 cmdline/handoff.h。
+    /// @param[out] out 追加到末尾
+    /// @return bool 被设置的选项或位置参数的类型不能编码时为false，out 不变
+    bool serialize(std::string &out) const
+    {
+        if (!serializable()) {
+            return false;
+        }
+        detail::put_u64(out, serial_magic);
+        detail::put_u64(out, fingerprint());
+        detail::put_bytes(out, prog_name.data(), prog_name.size());
+        detail::put_u64(out, set_bits.size());
+        for (auto word : set_bits) {
+            detail::put_u64(out, word);
+        }
+        for (auto *option : ordered) {
+            if (option->has_value() && test(option->index)) {
+                option->save(out);
+            }
+        }
+        for (auto *arg : positionals) {
+            arg->save(out);
+        }
+        detail::put_u64(out, others.size());
+        for (const auto &arg : others) {
+            detail::put_bytes(out, arg.data(), arg.size());
+        }
+        detail::put_u64(out, errors.size());
+        for (const auto &error : errors) {
+            detail::put_bytes(out, error.data(), error.size());
+        }
+        return true;
+    }
+
+    /// @brief 把解析结果编码为二进制
+    /// @return std::string 不能编码时为空，deserialize() 空的输入总是失败
+    std::string serialize() const
+    {
+        std::string ret;
+        serialize(ret);
+        return ret;
+    }
+
+    /// @brief 从 serialize() 的结果恢复解析结果，不需要分词和转换
+    /// @param[in] data
+    /// @param[in] size
+    /// @return bool 格式或选项定义的指纹不匹配时为false，此时解析器中的结果不确定，应改为调用 parse()
+    bool deserialize(const char *data, std::size_t size)
+    {
+        const char *p = data;
+        const char *const end = data + size;
+        std::uint64_t magic = 0;
+        std::uint64_t hash = 0;
+        std::uint64_t words = 0;
+        if (!detail::get_u64(p, end, magic) || magic != serial_magic || !detail::get_u64(p, end, hash) ||
+            hash != fingerprint()) {
+            return false;
+        }
+
+        const char *name = nullptr;
+        std::size_t name_size = 0;
+        if (!detail::get_bytes(p, end, name, name_size) || !detail::get_u64(p, end, words) ||
+            words != set_bits.size()) {
+            return false;
+        }
+        if (prog_name.empty()) {
+            prog_name.assign(name, name_size);
+        }
+        clear_set();
+        for (auto &word : set_bits) {
+            if (!detail::get_u64(p, end, word)) {
+                return false;
+            }
+        }
+        // 最后一个字中超出选项个数的位不能被设置，否则之后按位查找选项会越界
+        std::size_t const tail = ordered.size() % 64;
+        if (tail != 0 && (set_bits.back() >> tail) != 0) {
+            set_bits.back() = 0;
+            return false;
+        }
+        for (auto *option : ordered) {
+            if (option->has_value() && test(option->index) && !option->load(p, end)) {
+                return false;
+            }
+        }
+        for (auto *arg : positionals) {
+            if (!arg->load(p, end)) {
+                return false;
+            }
+        }
+
+        std::uint64_t count = 0;
+        if (!detail::get_u64(p, end, count)) {
+            return false;
+        }
+        rest_count = 0;
+        for (std::uint64_t i = 0; i < count; i++) {
+            const char *arg = nullptr;
+            std::size_t arg_size = 0;
+            if (!detail::get_bytes(p, end, arg, arg_size)) {
+                return false;
+            }
+            if (rest_count < others.size()) {
+                others[rest_count].assign(arg, arg_size);
+            } else {
+                others.emplace_back(arg, arg_size);
+            }
+            rest_count++;
+        }
+        others.resize(rest_count);
+
+        errors.clear();
+        if (!detail::get_u64(p, end, count)) {
+            return false;
+        }
+        for (std::uint64_t i = 0; i < count; i++) {
+            const char *error = nullptr;
+            std::size_t error_size = 0;
+            if (!detail::get_bytes(p, end, error, error_size)) {
+                return false;
+            }
+            errors.emplace_back(error, error_size);
+        }
+        return p == end;
+    }
+
+    /// @brief 从 serialize() 的结果恢复解析结果
+    /// @param[in] data
+    /// @return bool
+    bool deserialize(const std::string &data) { return deserialize(data.data(), data.size()); }
+
+    /// @brief 错误信息
+    /// @return std::string
+    std::string error() const { return !errors.empty() ? errors[0] : ""; }
+
+    /// @brief
+    /// @return std::string
+    std::string error_full() const
+    {
+        std::string ret;
+        for (const auto &error : errors) {
+            ret += error;
+            ret += '\n';
+        }
+        return ret;
+    }
+
+    /// @brief 使用帮助
+    /// @details 定义在 cmdline/usage.h 中(cmdline.h 已包含)，只包含 core.h 的翻译单元不能调用
+    /// @return std::string
+    std::string usage() const;
+
+#ifdef CMDLINE_ENABLE_STATS
+    /// @brief 累计的解析统计
+    /// @return parse_stats
+    parse_stats stats() const
+    {
+        parse_stats ret = total_stats;
+        for (auto *option : ordered) {
+            if (option->reader_total.count != 0) {
+                ret.options.push_back(option_stats{option->name(), option->reader_total});
+            }
+        }
+        return ret;
+    }
+
+    /// @brief 清空累计的统计
+    void reset_stats()
+    {
+        total_stats = parse_stats{};
+        for (auto *option : ordered) {
+            option->reader_total = phase_stats{};
+        }
+    }
+
+    /// @brief 每次解析结束后调用，参数是刚结束的这一次解析的统计
+    /// @param callback
+    void set_stats_callback(std::function<void(const parse_stats &)> callback) { stats_callback = std::move(callback); }
+#endif
+
+  private:
+    /// @brief 出错或指定了 --help 时输出使用帮助并退出程序，定义在 cmdline/usage.h 中
+    /// @param argc
+    /// @param ok
+    void check(int argc, bool ok) const;
+
+    class option_base;
+    template <class T>
+    class option_with_value;
+    template <class V>
+    class option_map;
+    template <class V, class F>
+    class option_map_with_reader;
+    class positional_base;
+    template <class T>
+    class positional_with_value;
+
+    enum class constraint_kind
+    {
+        depends,
+        conflicts,
+        exactly_one
+    };
+
+    /// @brief 约束位图中的一个非零字
+    struct mask_word
+    {
+        std::size_t word;
+        std::uint64_t bits;
+    };
+
+    /// @brief 编译后的约束，位图是 constraint_words[first, first + count)
+    struct constraint
+    {
+        constraint_kind kind;
+        /// @brief 触发约束的选项序号，exactly_one 不使用
+        std::size_t trigger;
+        std::size_t first;
+        std::size_t count;
+    };
+
+    /// @brief 在索引中二分查找第一个不小于name的位置
+    /// @param name 选项名
+    /// @param len 选项名长度
+    /// @return std::size_t
+    std::size_t lower_bound(const char *name, std::size_t len) const
+    {
+        std::size_t lo = 0;
+        std::size_t hi = index.size();
+        while (lo < hi) {
+            std::size_t const mid = lo + (hi - lo) / 2;
+            if (index[mid]->name().compare(0, std::string::npos, name, len) < 0) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    /// @brief 根据选项名查找选项
+    /// @param name 选项名，不要求以'\0'结尾
+    /// @param len 选项名长度
+    /// @return option_base* 不存在时为nullptr
+    option_base *find(const char *name, std::size_t len) const
+    {
+        std::size_t const pos = lower_bound(name, len);
+        if (pos < index.size() && index[pos]->name().compare(0, std::string::npos, name, len) == 0) {
+            return index[pos];
+        }
+        return nullptr;
+    }
+
+    /// @brief 按长选项名查找，计入统计
+    /// @param name 选项名，不要求以'\0'结尾
+    /// @param len 选项名长度
+    /// @return option_base* 不存在时为nullptr
+    option_base *find_long(const char *name, std::size_t len)
+    {
+        CMDLINE_STATS(detail::phase_timer const timer(current_stats.long_lookup);)
+        return find(name, len);
+    }
+
+    /// @brief 按描述表中的一项新建选项
+    static option_base *make_option(const option_def &entry)
+    {
+        if (entry.name == nullptr || *entry.name == '\0') {
+            throw cmdline_error("option name is empty");
+        }
+        switch (entry.kind) {
+            case option_kind::flag:
+                return new option_without_value(entry.name, entry.short_name, entry.desc != nullptr ? entry.desc : "");
+            case option_kind::boolean:
+                return make_option<bool>(entry);
+            case option_kind::integer:
+                return make_option<int>(entry);
+            case option_kind::int64:
+                return make_option<long long>(entry);
+            case option_kind::real:
+                return make_option<double>(entry);
+            case option_kind::string:
+                return make_option<std::string>(entry);
+        }
+        throw cmdline_error(std::string("unknown option kind: ") + entry.name);
+    }
+
+    template <class T>
+    static option_base *make_option(const option_def &entry)
+    {
+        T def = T();
+        if (entry.def != nullptr &&
+            !detail::converter<T>::from_string(entry.def, entry.def + std::strlen(entry.def), def)) {
+            throw cmdline_error(std::string("invalid default value: ") + entry.name + "=" + entry.def);
+        }
+        return new option_with_value_with_reader<T, default_reader<T>>(
+            entry.name, entry.short_name, entry.need, std::move(def), entry.desc != nullptr ? entry.desc : "",
+            default_reader<T>());
+    }
+
+    /// @brief 把新选项插入索引
+    /// @param pos lower_bound 返回的位置
+    /// @param option
+    void insert(std::size_t pos, option_base *option)
+    {
+        CMDLINE_STATS(detail::phase_timer const timer(total_stats.registration);)
+        short_dirty = true;
+        spec_dirty = true;
+        clear_cache();
+        option->index = ordered.size();
+        if (option->index / 64 >= set_bits.size()) {
+            set_bits.push_back(0);
+            required_bits.push_back(0);
+        }
+        if (option->must()) {
+            required_bits[option->index / 64] |= std::uint64_t(1) << (option->index % 64);
+        }
+        index.insert(index.begin() + static_cast<std::ptrdiff_t>(pos), option);
+        ordered.push_back(option);
+    }
+
+    /// @brief 解析参数
+    /// @param argc 参数个数
+    /// @param argv 参数内容
+    /// @return bool
+    bool parse_args(int argc, const char *const argv[])
+    {
+        if (argc < 1) {
+            return abort_parse("argument number must be longer than 0");
+        }
+        reset_result(static_cast<std::size_t>(argc));
+        if (prog_name.empty()) {
+            prog_name = argv[0];
+        }
+
+        // 短选项表只在添加选项后重建
+        if (short_dirty) {
+            CMDLINE_STATS(detail::phase_timer const timer(current_stats.short_table);)
+            build_short_table();
+        }
+        if (short_ambiguous) {
+            return abort_parse(std::string("short option '") + short_ambiguous + "' is ambiguous");
+        }
+
+        for (int i = 1; i < argc; i++) {
+            if (strncmp(argv[i], "--", 2) == 0) {
+                const char *name = argv[i] + 2;
+                const char *p = strchr(name, '=');
+                if (p) {
+                    set_option(name, static_cast<std::size_t>(p - name), p + 1);
+                } else {
+                    std::size_t const len = strlen(name);
+                    option_base *option = find_long(name, len);
+                    if (option == nullptr) {
+                        errors.push_back("undefined option: --" + std::string(name, len));
+                        continue;
+                    }
+                    if (option->has_value()) {
+                        if (i + 1 >= argc) {
+                            errors.push_back("option needs value: --" + option->name());
+                            continue;
+                        }
+                        i++;
+                        set_option(option, argv[i]);
+
+                    } else {
+                        set_option(option);
+                    }
+                }
+            } else if (strncmp(argv[i], "-", 1) == 0) {
+                if (!argv[i][1]) {
+                    continue;
+                }
+                char last = argv[i][1];
+                for (int j = 2; argv[i][j]; j++) {
+                    last = argv[i][j];
+                    option_base *option = short_table[static_cast<unsigned char>(argv[i][j - 1])];
+                    if (option == nullptr) {
+                        errors.push_back(std::string("undefined short option: -") + argv[i][j - 1]);
+                        continue;
+                    }
+                    set_option(option);
+                }
+
+                option_base *option = short_table[static_cast<unsigned char>(last)];
+                if (option == nullptr) {
+                    errors.push_back(std::string("undefined short option: -") + last);
+                    continue;
+                }
+
+                if (i + 1 < argc && option->has_value()) {
+                    set_option(option, argv[i + 1]);
+                    i++;
+                } else {
+                    set_option(option);
+                }
+            } else {
+                add_argument(argv[i]);
+            }
+        }
+        others.resize(rest_count);
+        for (auto *arg : positionals) {
+            arg->finish();
+        }
+
+        if (!deferred_tasks.empty()) {
+            CMDLINE_STATS(detail::phase_timer const timer(current_stats.reader);)
+            run_deferred();
+        }
+
+        {
+            CMDLINE_STATS(detail::phase_timer const timer(current_stats.required);)
+            // 先按字检查是否缺少必填项，只有缺少时才按选项名的顺序逐个报告
+            bool missing = false;
+            for (std::size_t w = 0; w < set_bits.size(); w++) {
+                missing = missing || (required_bits[w] & ~set_bits[w]) != 0;
+            }
+            if (missing) {
+                for (auto *option : index) {
+                    if (option->must() && !test(option->index)) {
+                        errors.push_back("need option: --" + option->name());
+                    }
+                }
+            }
+            check_constraints();
+            // 必填的位置参数都在前面，没有绑定到的就是缺少的
+            for (std::size_t i = positional_next; i < positionals.size(); i++) {
+                if (positionals[i]->count() == arity::single) {
+                    errors.push_back("need argument: " + positionals[i]->name());
+                }
+            }
+        }
+
+        return errors.empty();
+    }
+
+    /// @brief 编译约束：把选项名转换为位图中非零的字
+    void add_constraint(constraint_kind kind, std::size_t trigger, const std::vector<std::string> &names)
+    {
+        if (names.empty()) {
+            throw cmdline_error("empty constraint");
+        }
+        flag_set const m = mask(names);
+        constraint c{kind, trigger, constraint_words.size(), 0};
+        for (std::size_t w = 0; w < m.bits.size(); w++) {
+            if (m.bits[w] != 0) {
+                constraint_words.push_back(mask_word{w, m.bits[w]});
+                c.count++;
+            }
+        }
+        constraints.push_back(c);
+        clear_cache();
+    }
+
+    /// @brief 逐个检查约束，每个约束只访问它涉及的字
+    void check_constraints()
+    {
+        for (const auto &c : constraints) {
+            const mask_word *const m = constraint_words.data() + c.first;
+            if (c.kind == constraint_kind::exactly_one) {
+                std::size_t n = 0;
+                for (std::size_t k = 0; k < c.count && n < 2; k++) {
+                    for (std::uint64_t word = m[k].bits & set_bits[m[k].word]; word != 0 && n < 2; word &= word - 1) {
+                        n++;
+                    }
+                }
+                if (n == 0) {
+                    errors.push_back("need one of: " + constraint_options(c, false));
+                } else if (n > 1) {
+                    errors.push_back("options are mutually exclusive: " + constraint_options(c, true));
+                }
+                continue;
+            }
+
+            if (!test(c.trigger)) {
+                continue;
+            }
+            bool const depends = c.kind == constraint_kind::depends;
+            std::uint64_t bad = 0;
+            for (std::size_t k = 0; k < c.count; k++) {
+                std::uint64_t const have = set_bits[m[k].word];
+                bad |= m[k].bits & (depends ? ~have : have);
+            }
+            if (bad != 0) {
+                errors.push_back("option --" + ordered[c.trigger]->name() +
+                                 (depends ? " requires " : " conflicts with ") + constraint_options(c, !depends));
+            }
+        }
+    }
+
+    /// @brief 约束中的选项名，按添加顺序用逗号分隔
+    /// @param c
+    /// @param set true-只列出被设置的选项，false-只列出没有被设置的选项(exactly_one 时列出全部)
+    std::string constraint_options(const constraint &c, bool set) const
+    {
+        std::string ret;
+        const mask_word *const m = constraint_words.data() + c.first;
+        for (std::size_t k = 0; k < c.count; k++) {
+            std::uint64_t const have = set_bits[m[k].word];
+            std::uint64_t word = m[k].bits & (set ? have : ~have);
+            for (unsigned bit = 0; word != 0; bit++, word >>= 1) {
+                if ((word & 1) != 0) {
+                    ret += ret.empty() ? "--" : ", --";
+                    ret += ordered[m[k].word * 64 + bit]->name();
+                }
+            }
+        }
+        return ret;
+    }
+
+    /// @brief 重建短选项表，按选项名的顺序检查缩写是否重复
+    void build_short_table()
+    {
+        for (auto &slot : short_table) {
+            slot = nullptr;
+        }
+        short_ambiguous = '\0';
+        for (auto *option : index) {
+            char const initial = option->short_name();
+            if (option->name().empty() || !initial) {
+                continue;
+            }
+            option_base *&slot = short_table[static_cast<unsigned char>(initial)];
+            if (slot != nullptr) {
+                short_ambiguous = initial;
+                break;
+            }
+            slot = option;
+        }
+        short_dirty = false;
+    }
+
+    /// @brief 开始一次解析：清除错误和上一次设置的选项
+    /// @details others 和位置参数中的值留到解析结束时再截断，以复用其容量
+    /// @param argc 参数个数，位置参数按它预留空间
+    void reset_result(std::size_t argc)
+    {
+        CMDLINE_STATS(detail::phase_timer const timer(current_stats.reset);)
+        errors.clear();
+        rest_count = 0;
+        cache_skip = false;
+        deferred.clear();
+        deferred_tasks.clear();
+        clear_set();
+        positional_next = 0;
+        for (auto *arg : positionals) {
+            arg->begin(argc);
+        }
+        CMDLINE_STATS(for (auto *option : ordered) { option->reader_last = phase_stats{}; })
+    }
+
+    /// @brief 还没有处理参数就失败：清除上一次的结果，只留下这一个错误
+    /// @param error
+    /// @return bool 总是false
+    bool abort_parse(std::string error)
+    {
+        reset_result(0);
+        others.clear();
+        for (auto *arg : positionals) {
+            arg->finish();
+        }
+        errors.push_back(std::move(error));
+        return false;
+    }
+
+    /// @brief 分词，结果写入复用的 tokens，只有 tokens[0, argc) 有效
+    /// @param[in] arg
+    /// @param[out] argc 参数个数
+    /// @return const char* 引号或转义不完整时为错误信息，否则为nullptr
+    const char *tokenize(const std::string &arg, std::size_t &argc)
+    {
+        argc = 0;
+        next_token(argc);
+
+        bool in_quote = false;
+        for (std::string::size_type i = 0; i < arg.length(); i++) {
+            if (arg[i] == '\"') {
+                in_quote = !in_quote;
+                continue;
+            }
+
+            if (arg[i] == ' ' && !in_quote) {
+                next_token(++argc);
+                continue;
+            }
+
+            if (arg[i] == '\\') {
+                i++;
+                if (i >= arg.length()) {
+                    return "unexpected occurrence of '\\' at end of string";
+                }
+            }
+
+            tokens[argc] += arg[i];
+        }
+
+        if (in_quote) {
+            return "quote is not closed";
+        }
+
+        if (tokens[argc].length() > 0) {
+            argc++;
+        }
+        return nullptr;
+    }
+
+    /// @brief 清空 tokens[i] 作为下一个参数的缓冲区
+    /// @param i
+    void next_token(std::size_t i)
+    {
+        if (i < tokens.size()) {
+            tokens[i].clear();
+        } else {
+            tokens.emplace_back();
+        }
+    }
+
+    /// @brief 把不是选项的参数绑定到下一个位置参数上，没有可绑定的位置参数时进入 rest()
+    /// @param arg
+    void add_argument(const char *arg)
+    {
+        if (positional_next >= positionals.size()) {
+            add_rest(arg);
+            return;
+        }
+        positional_base *p = positionals[positional_next];
+        bool ok = false;
+        {
+            CMDLINE_STATS(detail::phase_timer const timer(current_stats.reader);)
+            try {
+                ok = p->add(arg, strlen(arg));
+            } catch (const std::exception & /*e*/) {
+                ok = false;
+            }
+        }
+        if (!ok) {
+            errors.push_back("argument value is invalid: " + p->name() + "=" + arg);
+        }
+        if (p->count() != arity::variadic) {
+            positional_next++;
+        }
+    }
+
+    template <class T>
+    option_with_value<T> *typed_option(const std::string &name) const
+    {
+        option_base *base = find(name.data(), name.size());
+        if (base == nullptr) {  // 选项不存在
+            throw cmdline_error("there is no flag: --" + name);
+        }
+        option_with_value<T> *p = dynamic_cast<option_with_value<T> *>(base);
+        if (p == nullptr) {
+            throw cmdline_error("type mismatch flag '" + name + "'");
+        }
+        return p;
+    }
+
+    /// @brief 校验句柄属于这个 parser，返回选项的添加顺序
+    std::size_t handle_index(const flag_handle &h) const
+    {
+        if (h.idx >= ordered.size() || ordered[h.idx] != h.option) {
+            throw cmdline_error("invalid handle");
+        }
+        return h.idx;
+    }
+
+    /// @details 类型在 handle<T>() 中已经检查过，校验通过后的转换是安全的
+    template <class T>
+    option_with_value<T> *handle_option(const value_handle<T> &h) const
+    {
+        return static_cast<option_with_value<T> *>(ordered[handle_index(h)]);
+    }
+
+    positional_base *find_positional(const std::string &name) const
+    {
+        for (auto *arg : positionals) {
+            if (arg->name() == name) {
+                return arg;
+            }
+        }
+        return nullptr;
+    }
+
+    template <class T>
+    const positional_with_value<T> *typed_positional(const std::string &name) const
+    {
+        const positional_base *base = find_positional(name);
+        if (base == nullptr) {
+            throw cmdline_error("there is no argument: " + name);
+        }
+        const positional_with_value<T> *p = dynamic_cast<const positional_with_value<T> *>(base);
+        if (p == nullptr) {
+            throw cmdline_error("type mismatch argument '" + name + "'");
+        }
+        return p;
+    }
+
+    /// @brief 追加一个其余参数，尽量复用 others 中已有的字符串
+    /// @param arg
+    void add_rest(const char *arg)
+    {
+        if (rest_count < others.size()) {
+            others[rest_count].assign(arg);
+        } else {
+            others.emplace_back(arg);
+        }
+        rest_count++;
+    }
+
+    /// @brief 设置选项标记
+    /// @param option
+    void set_option(option_base *option)
+    {
+        mark(option->index);
+    }
+
+    /// @brief 设置选项内容
+    /// @param option
+    /// @param value
+    void set_option(option_base *option, const char *value)
+    {
+        cache_skip = cache_skip || option->uncacheable;
+        if (exec != nullptr && option->independent) {
+            defer(option, value);
+            return;
+        }
+        bool ok = false;
+        {
+            CMDLINE_STATS(detail::phase_timer const timer(current_stats.reader, &option->reader_last);)
+            ok = option->set(value, strlen(value));
+        }
+        if (!ok) {
+            errors.push_back("option value is invalid: --" + option->name() + "=" + value);
+            return;
+        }
+        mark(option->index);
+    }
+
+    /// @brief 推迟调用独立的 reader，同一个选项的多次出现串成一条链，由同一个任务依次执行
+    void defer(option_base *option, const char *value)
+    {
+        std::size_t const n = deferred.size();
+        deferred.emplace_back();
+        deferred_call &call = deferred[n];
+        call.option = option;
+        call.value = value;
+        call.error_pos = errors.size();
+        call.next = npos;
+        call.ok = false;
+
+        // deferred_last 只在本次解析中有效：指向本次的调用才算数
+        std::size_t const last = option->deferred_last;
+        if (last < n && deferred[last].option == option && deferred[last].next == npos) {
+            deferred[last].next = n;
+        } else {
+            deferred_tasks.push_back(n);
+        }
+        option->deferred_last = n;
+    }
+
+    /// @brief 执行一个选项的所有推迟的调用
+    static void run_chain(void *context, std::size_t task)
+    {
+        parser &self = *static_cast<parser *>(context);
+        for (std::size_t i = self.deferred_tasks[task]; i != npos; i = self.deferred[i].next) {
+            deferred_call &call = self.deferred[i];
+            CMDLINE_STATS(detail::phase_timer const timer(call.option->reader_last);)
+            try {
+                call.ok = call.option->set(call.value, strlen(call.value));
+            } catch (...) {
+                // set() 已经把 std::exception 当作参数无效，这里只有其他异常，留给解析线程重新抛出
+                call.ok = false;
+                call.thrown = std::current_exception();
+                return;
+            }
+        }
+    }
+
+    /// @brief 并发执行推迟的 reader，按参数顺序标记选项并合并错误信息
+    void run_deferred()
+    {
+        if (deferred_tasks.size() == 1) {
+            run_chain(this, 0);
+        } else {
+            exec->run(deferred_tasks.size(), &parser::run_chain, this);
+        }
+
+        // 与依次调用时一样，按参数顺序第一个抛出的异常传给调用者
+        for (const auto &call : deferred) {
+            if (call.thrown) {
+                std::rethrow_exception(call.thrown);
+            }
+        }
+
+        bool failed = false;
+        for (const auto &call : deferred) {
+            if (call.ok) {
+                mark(call.option->index);
+            } else {
+                failed = true;
+            }
+        }
+        if (!failed) {
+            return;
+        }
+
+        // 失败的调用插回它在扫描参数时所处的位置
+        std::vector<std::string> merged;
+        std::size_t k = 0;
+        for (const auto &call : deferred) {
+            if (call.ok) {
+                continue;
+            }
+            for (; k < call.error_pos; k++) {
+                merged.push_back(std::move(errors[k]));
+            }
+            merged.push_back("option value is invalid: --" + call.option->name() + "=" + call.value);
+        }
+        for (; k < errors.size(); k++) {
+            merged.push_back(std::move(errors[k]));
+        }
+        errors.swap(merged);
+    }
+
+    /// @brief 在缓存中查找 cache_key，命中时恢复解析结果
+    /// @param[out] ok 命中时为解析结果是否有效
+    /// @return bool 是否命中
+    bool cache_lookup(bool &ok)
+    {
+        cache_hash = detail::fnv1a(cache_key.data(), cache_key.size());
+        for (std::size_t i = 0; i < cache_hashes.size(); i++) {
+            cache_entry &entry = cache_entries[i];
+            if (cache_hashes[i] != cache_hash || entry.key != cache_key) {
+                continue;
+            }
+            if (!deserialize(entry.value)) {
+                break;
+            }
+            entry.used = ++cache_tick;
+            cache_hit_count++;
+            ok = errors.empty();
+            return true;
+        }
+        cache_miss_count++;
+        return false;
+    }
+
+    /// @brief 保存刚完成的解析结果，键为 cache_key
+    void cache_store()
+    {
+        if (cache_capacity == 0 || cache_skip || !serializable()) {
+            return;
+        }
+        std::size_t slot = cache_entries.size();
+        if (slot >= cache_capacity) {
+            // 淘汰最久没有使用的结果，复用它的字符串
+            slot = 0;
+            for (std::size_t i = 1; i < cache_entries.size(); i++) {
+                if (cache_entries[i].used < cache_entries[slot].used) {
+                    slot = i;
+                }
+            }
+        } else {
+            cache_entries.emplace_back();
+            cache_hashes.push_back(0);
+        }
+        cache_entry &entry = cache_entries[slot];
+        cache_hashes[slot] = cache_hash;
+        entry.key = cache_key;
+        entry.value.clear();
+        serialize(entry.value);
+        entry.used = ++cache_tick;
+    }
+
+    /// @brief 当前的解析结果能否编码：所有位置参数和被设置的有参数选项都有编码
+    bool serializable() const
+    {
+        for (auto *arg : positionals) {
+            if (!arg->serializable) {
+                return false;
+            }
+        }
+        for (auto *option : ordered) {
+            if (!option->serializable && test(option->index)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// @brief 清除所有选项的设置状态，上一次设置过的选项恢复默认值，
+    /// 同一个 parser 反复解析时结果不会带上之前的值
+    void clear_set()
+    {
+        for (std::size_t w = 0; w < set_bits.size(); w++) {
+            std::uint64_t word = set_bits[w];
+            for (std::size_t i = w * 64; word != 0; i++, word >>= 1) {
+                if ((word & 1) != 0) {
+                    ordered[i]->clear();
+                }
+            }
+            set_bits[w] = 0;
+        }
+    }
+
+    /// @brief 标记第i个选项已设置
+    /// @param i 添加顺序
+    void mark(std::size_t i) { set_bits[i / 64] |= std::uint64_t(1) << (i % 64); }
+
+    /// @brief 第i个选项是否已设置
+    /// @param i 添加顺序
+    /// @return bool
+    bool test(std::size_t i) const { return (set_bits[i / 64] >> (i % 64)) & 1; }
+
+    /// @brief 根据选项名设置选项内容
+    /// @param name 选项名，不要求以'\0'结尾
+    /// @param len 选项名长度
+    /// @param value
+    void set_option(const char *name, std::size_t len, const char *value)
+    {
+        option_base *option = find_long(name, len);
+        if (option == nullptr) {
+            errors.push_back("undefined option: --" + std::string(name, len));
+            return;
+        }
+        set_option(option, value);
+    }
+
+    /// @brief 选项基类
+    class option_base
+    {
+      public:
+        virtual ~option_base() = default;
+
+        /// @brief 是否存在参数
+        /// @return bool true-存在参数; false-不存在参数
+        virtual bool has_value() const = 0;
+        /// @brief 设置选项的内容
+        /// @param[in] value 不要求以'\0'结尾
+        /// @param[in] len
+        /// @return bool true-参数合法
+        virtual bool set(const char * /*value*/, std::size_t /*len*/) { return false; }
+        virtual bool must() const = 0;
+
+        virtual const std::string &name() const = 0;
+        virtual char short_name() const = 0;
+        /// @brief 帮助信息中的描述
+        /// @param width 默认值最多显示的字符数，0 表示不限制
+        virtual std::string description(std::size_t width) const = 0;
+        virtual std::string short_description() const = 0;
+
+        /// @brief 把值编码后追加到 out，只对有参数的选项调用
+        virtual void save(std::string & /*out*/) const {}
+        /// @brief 从 p 读取 save() 写入的值
+        virtual bool load(const char *& /*p*/, const char * /*end*/) { return false; }
+        /// @brief 恢复默认值
+        virtual void clear() {}
+
+        /// @brief 添加顺序，也是在位图中的下标
+        std::size_t index{0};
+        /// @brief reader 有副作用，设置了本选项的解析结果不进入缓存
+        bool uncacheable{false};
+        /// @brief 值的类型有编码，见 detail::codec
+        bool serializable{true};
+        /// @brief reader 可以交给执行器并发调用
+        bool independent{false};
+        /// @brief 本选项最近一次推迟的调用在 deferred 中的下标
+        std::size_t deferred_last{static_cast<std::size_t>(-1)};
+
+        CMDLINE_STATS(phase_stats reader_last{}; phase_stats reader_total{};)
+    };
+
+    /// @brief 无参数选项
+    class option_without_value : public option_base
+    {
+      public:
+        /// @brief 无参数选项
+        /// @param name 选项名
+        /// @param short_name 选项名缩写
+        /// @param desc 描述
+        option_without_value(std::string name, char short_name, std::string desc)
+            : _name(std::move(name)), _short_name(short_name), _desc(std::move(desc))
+        {
+        }
+        ~option_without_value() override = default;
+
+        bool has_value() const override { return false; }
+
+        bool must() const override { return false; }
+
+        const std::string &name() const override { return _name; }
+
+        char short_name() const override { return _short_name; }
+
+        std::string description(std::size_t /*width*/) const override { return _desc; }
+
+        std::string short_description() const override { return "--" + _name; }
+
+      private:
+        std::string _name{};
+        char _short_name{'\0'};
+        std::string _desc{};
+    };
+
+    /// @brief 有参数选项
+    /// @tparam T 参数类型
+    template <class T>
+    class option_with_value : public option_base
+    {
+      public:
+        /// @brief 有参数选项
+        /// @param name 选项名
+        /// @param short_name 选项名缩写
+        /// @param need 必填项？
+        /// @param def 默认值
+        /// @param desc 描述
+        option_with_value(std::string name, char short_name, bool need, T def, const std::string &desc)
+            : _name(std::move(name)), _short_name(short_name), _need(need), _desc(desc), _def(std::move(def)),
+              _actual(detail::initial_value(_def))
+        {
+            this->serializable = detail::codec<T>::supported;
+        }
+        ~option_with_value() override = default;
+
+        /// @brief 当前的值，没有设置过时为默认值
+        const T &get() const { return _has_actual ? _actual : _def; }
+
+        /// @brief 移出当前的值，之后 get() 返回默认值；没有设置过时返回默认值的拷贝
+        T take()
+        {
+            if (!_has_actual) {
+                return _def;
+            }
+            _has_actual = false;
+            return std::move(_actual);
+        }
+
+        bool has_value() const override { return true; }
+
+        /// @brief 设置选项的内容
+        /// @param value 选项参数内容
+        /// @param len
+        /// @return bool true-参数合法
+        bool set(const char *value, std::size_t len) override
+        {
+            try {
+                if (!read(value, value + len, _actual)) {
+                    return false;
+                }
+            } catch (const std::exception & /*e*/) {
+                return false;
+            }
+            _has_actual = true;
+            return true;
+        }
+
+        bool must() const override { return _need; }
+
+        const std::string &name() const override { return _name; }
+
+        char short_name() const override { return _short_name; }
+
+        /// @details 默认值在显示时才转换，注册很大的默认值时不拷贝
+        std::string description(std::size_t width) const override
+        {
+            return _desc + " (" + detail::readable_typename<T>() +
+                   (_need ? "" : " [=" + detail::default_value<T>(_def, width) + "]") + ")";
+        }
+
+        std::string short_description() const override { return "--" + _name + "=" + detail::readable_typename<T>(); }
+
+        void save(std::string &out) const override { detail::codec<T>::save(get(), out); }
+
+        bool load(const char *&p, const char *end) override
+        {
+            _has_actual = detail::codec<T>::load(p, end, _actual);
+            return _has_actual;
+        }
+
+        /// @brief 只清除标记，_actual 保留已有的容量供下次解析复用
+        void clear() override { _has_actual = false; }
+
+      protected:
+        /// @brief 把 [first, last) 转换后写入 out
+        /// @return bool false-内容不合法，此时 out 不变
+        virtual bool read(const char *first, const char *last, T &out) = 0;
+
+        std::string _name{};
+        char _short_name{'\0'};
+        bool _need{true};
+        std::string _desc{};
+
+        T _def;
+        /// @brief 解析得到的值，只有 _has_actual 为true时有效
+        T _actual;
+        bool _has_actual{false};
+    };
+
+    /// @brief 有参数并且限制范围的选项
+    /// @tparam T 参数类型
+    /// @tparam F oneof
+    template <class T, class F>
+    class option_with_value_with_reader : public option_with_value<T>
+    {
+      public:
+        /// @brief 有参数并且限制范围的选项
+        /// @param name 选项名
+        /// @param short_name 选项名缩写
+        /// @param need 必填项？
+        /// @param def 默认值
+        /// @param desc 描述
+        /// @param reader 范围限制
+        option_with_value_with_reader(const std::string &name, char short_name, bool need, T def,
+                                      const std::string &desc, F reader)
+            : option_with_value<T>(name, short_name, need, std::move(def), desc), reader(std::move(reader))
+        {
+        }
+
+      private:
+        bool read(const char *first, const char *last, T &out) override
+        {
+            return detail::read_value(reader, first, last, buf, out);
+        }
+
+        F reader;
+        /// @brief 给只接受 std::string 的 reader 复用的缓冲区
+        std::string buf{};
+    };
+
+    /// @brief 键值对选项
+    template <class V>
+    class option_map : public option_base
+    {
+      public:
+        option_map(const std::string &name, char short_name, const std::string &desc)
+            : _name(name), _short_name(short_name), _desc(desc + " (key=" + detail::readable_typename<V>() + " ...)")
+        {
+            this->serializable = detail::codec<V>::supported;
+        }
+
+        const flat_map<V> &get() const { return map; }
+
+        bool has_value() const override { return true; }
+
+        /// @brief 按逗号拆分，全部转换成功后再合并到映射中
+        /// @details 每一项都必须是 `k=v`，空的项(包括结尾的逗号)是错误。
+        /// 任何一项失败时这次出现的内容都不合并，之前出现的内容保持不变。
+        bool set(const char *value, std::size_t len) override
+        {
+            const char *const end = value + len;
+            const char *item = value;
+            pending_size = 0;
+            while (true) {
+                const char *comma = item;
+                while (comma < end && *comma != ',') {
+                    comma++;
+                }
+                const char *eq = item;
+                while (eq < comma && *eq != '=') {
+                    eq++;
+                }
+                if (eq == item || eq == comma) {
+                    return false;
+                }
+                if (pending_size == pending.size()) {
+                    pending.emplace_back();
+                }
+                typename flat_map<V>::value_type &slot = pending[pending_size];
+                slot.first = string_ref(item, static_cast<std::size_t>(eq - item));
+                bool ok = false;
+                try {
+                    ok = read(eq + 1, comma, slot.second);
+                } catch (const std::exception & /*e*/) {
+                    ok = false;
+                }
+                if (!ok) {
+                    return false;
+                }
+                pending_size++;
+                if (comma == end) {
+                    break;
+                }
+                item = comma + 1;
+            }
+            for (std::size_t i = 0; i < pending_size; i++) {
+                merge(pending[i]);
+            }
+            return true;
+        }
+
+        bool must() const override { return false; }
+
+        const std::string &name() const override { return _name; }
+
+        char short_name() const override { return _short_name; }
+
+        std::string description(std::size_t /*width*/) const override { return _desc; }
+
+        std::string short_description() const override
+        {
+            return "--" + _name + "=key=" + detail::readable_typename<V>();
+        }
+
+        void save(std::string &out) const override
+        {
+            detail::put_u64(out, map.entries.size());
+            for (const auto &entry : map.entries) {
+                detail::put_bytes(out, entry.first.data(), entry.first.size());
+                detail::codec<V>::save(entry.second, out);
+            }
+        }
+
+        /// @brief 读取后键和值中的视图指向输入缓冲区，再一次性拷贝到 storage 中
+        bool load(const char *&p, const char *end) override
+        {
+            std::uint64_t n = 0;
+            if (!detail::get_u64(p, end, n) || n > static_cast<std::uint64_t>(end - p)) {
+                return false;
+            }
+            map.entries.clear();
+            map.entries.reserve(static_cast<std::size_t>(n));
+            std::size_t bytes = 0;
+            for (std::uint64_t i = 0; i < n; i++) {
+                const char *key = nullptr;
+                std::size_t key_size = 0;
+                if (!detail::get_bytes(p, end, key, key_size)) {
+                    return false;
+                }
+                map.entries.emplace_back(string_ref(key, key_size), V());
+                if (!detail::codec<V>::load(p, end, map.entries.back().second)) {
+                    return false;
+                }
+                bytes += key_size + detail::view_bytes(map.entries.back().second);
+            }
+
+            storage.resize(bytes);
+            char *dst = &storage[0];
+            for (auto &entry : map.entries) {
+                detail::rebase(entry.first, dst);
+                detail::rebase(entry.second, dst);
+            }
+            return true;
+        }
+
+        void clear() override { map.entries.clear(); }
+
+      protected:
+        /// @brief 把 [first, last) 转换后写入 out
+        /// @return bool false-内容不合法，此时 out 不变
+        virtual bool read(const char *first, const char *last, V &out) = 0;
+
+      private:
+        /// @brief 插入或覆盖一个键，保持按键排序；值交换过去，原来的存储留在 item 中复用
+        void merge(typename flat_map<V>::value_type &item)
+        {
+            std::size_t const pos = map.lower_bound(item.first);
+            if (pos < map.entries.size() && map.entries[pos].first == item.first) {
+                std::swap(map.entries[pos].second, item.second);
+                return;
+            }
+            map.entries.insert(map.entries.begin() + static_cast<std::ptrdiff_t>(pos), item);
+        }
+
+        std::string _name{};
+        char _short_name{'\0'};
+        std::string _desc{};
+        flat_map<V> map{};
+        /// @brief 这次出现中已经转换好、等待合并的项，跨解析复用
+        std::vector<typename flat_map<V>::value_type> pending{};
+        std::size_t pending_size{0};
+        /// @brief deserialize() 后键和值所在的存储
+        std::string storage{};
+    };
+
+    template <class V, class F>
+    class option_map_with_reader : public option_map<V>
+    {
+      public:
+        option_map_with_reader(const std::string &name, char short_name, const std::string &desc, F reader)
+            : option_map<V>(name, short_name, desc), reader(std::move(reader))
+        {
+        }
+
+      private:
+        bool read(const char *first, const char *last, V &out) override
+        {
+            return detail::read_value(reader, first, last, buf, out);
+        }
+
+        F reader;
+        /// @brief 给只接受 std::string 的 reader 复用的缓冲区
+        std::string buf{};
+    };
+
+    /// @brief 位置参数基类
+    class positional_base
+    {
+      public:
+        positional_base(const std::string &name, const std::string &desc, arity count)
+            : _name(name), _desc(desc), _count(count)
+        {
+        }
+        virtual ~positional_base() = default;
+
+        const std::string &name() const { return _name; }
+        arity count() const { return _count; }
+
+        /// @brief 开始一次解析
+        /// @param argc 参数个数，剩余参数按它预留空间
+        virtual void begin(std::size_t argc) = 0;
+        /// @brief 转换并追加一个值
+        /// @return bool false-内容不合法
+        virtual bool add(const char *value, std::size_t len) = 0;
+        /// @brief 结束一次解析，截掉上一次多出来的值
+        virtual void finish() = 0;
+        /// @brief 本次得到的值的个数
+        virtual std::size_t size() const = 0;
+
+        virtual std::string type_name() const = 0;
+        /// @brief 帮助信息中的描述
+        /// @param width 默认值最多显示的字符数，0 表示不限制
+        virtual std::string description(std::size_t width) const = 0;
+
+        virtual void save(std::string &out) const = 0;
+        virtual bool load(const char *&p, const char *end) = 0;
+
+        /// @brief 值的类型有编码，见 detail::codec
+        bool serializable{true};
+
+      protected:
+        std::string _name{};
+        std::string _desc{};
+        arity _count{arity::single};
+    };
+
+    /// @brief 有类型的位置参数，所有的值放在一个复用的数组中
+    template <class T>
+    class positional_with_value : public positional_base
+    {
+      public:
+        positional_with_value(const std::string &name, const std::string &desc, arity count, T def)
+            : positional_base(name, desc, count), _def(std::move(def))
+        {
+            this->serializable = detail::codec<T>::supported;
+        }
+
+        const T &get() const { return _values.empty() ? _def : _values[0]; }
+        const std::vector<T> &values() const { return _values; }
+
+        /// @brief 移出所有的值，之后为空
+        std::vector<T> take()
+        {
+            std::vector<T> ret;
+            ret.swap(_values);
+            used = 0;
+            return ret;
+        }
+
+        void begin(std::size_t argc) override
+        {
+            used = 0;
+            if (_count == arity::variadic) {
+                _values.reserve(argc);
+            }
+        }
+
+        bool add(const char *value, std::size_t len) override
+        {
+            // 与 rest() 相同，尽量复用上一次解析留下的元素
+            if (used < _values.size()) {
+                if (!read(value, value + len, _values[used])) {
+                    return false;
+                }
+            } else {
+                _values.emplace_back();
+                if (!read(value, value + len, _values.back())) {
+                    _values.pop_back();
+                    return false;
+                }
+            }
+            used++;
+            return true;
+        }
+
+        void finish() override { _values.resize(used); }
+
+        std::size_t size() const override { return _values.size(); }
+
+        std::string type_name() const override { return detail::readable_typename<T>(); }
+
+        std::string description(std::size_t width) const override
+        {
+            switch (_count) {
+                case arity::single:
+                    return _desc + " (" + type_name() + ")";
+                case arity::optional:
+                    return _desc + " (" + type_name() + " [=" + detail::default_value<T>(_def, width) + "])";
+                default:
+                    return _desc + " (" + type_name() + " ...)";
+            }
+        }
+
+        void save(std::string &out) const override
+        {
+            detail::put_u64(out, _values.size());
+            for (const auto &v : _values) {
+                detail::codec<T>::save(v, out);
+            }
+        }
+
+        bool load(const char *&p, const char *end) override
+        {
+            std::uint64_t n = 0;
+            if (!detail::get_u64(p, end, n) || n > static_cast<std::uint64_t>(end - p)) {
+                return false;
+            }
+            _values.resize(static_cast<std::size_t>(n));
+            for (auto &v : _values) {
+                if (!detail::codec<T>::load(p, end, v)) {
+                    return false;
+                }
+            }
+            used = _values.size();
+            return true;
+        }
+
+      protected:
+        /// @brief 把 [first, last) 转换后写入 out
+        /// @return bool false-内容不合法
+        virtual bool read(const char *first, const char *last, T &out) = 0;
+
+      private:
+        T _def;
+        std::vector<T> _values{};
+        /// @brief 本次解析已经得到的值的个数
+        std::size_t used{0};
+    };
+
+    template <class T, class F>
+    class positional_with_reader : public positional_with_value<T>
+    {
+      public:
+        positional_with_reader(const std::string &name, const std::string &desc, arity count, T def, F reader)
+            : positional_with_value<T>(name, desc, count, std::move(def)), reader(std::move(reader))
+        {
+        }
+
+      private:
+        bool read(const char *first, const char *last, T &out) override
+        {
+            return detail::read_value(reader, first, last, buf, out);
+        }
+
+        F reader;
+        /// @brief 给只接受 std::string 的 reader 复用的缓冲区
+        std::string buf{};
+    };
+
+    /// @brief 短选项表，以缩写字符为下标
+    option_base *short_table[256]{};
+    /// @brief 重复的缩写，没有重复时为'\0'
+    char short_ambiguous{'\0'};
+    /// @brief 添加选项后需要重建短选项表
+    bool short_dirty{true};
+
+#ifdef CMDLINE_ENABLE_STATS
+    /// @brief 开始一次解析的统计，parse(const std::string &) 嵌套调用时只生效一次
+    void begin_stats()
+    {
+        if (stats_active) {
+            return;
+        }
+        stats_active = true;
+        current_stats.begin_ns = detail::now_ns();
+        allocations_begin = detail::allocations();
+    }
+
+    /// @brief 结束一次解析的统计，累加并回调
+    void end_stats()
+    {
+        current_stats.parses = 1;
+        current_stats.total = phase_stats{1, detail::now_ns() - current_stats.begin_ns};
+        current_stats.allocations = detail::allocations() - allocations_begin;
+        for (auto *option : ordered) {
+            if (option->reader_last.count == 0) {
+                continue;
+            }
+            option->reader_total += option->reader_last;
+            if (stats_callback) {
+                current_stats.options.push_back(option_stats{option->name(), option->reader_last});
+            }
+        }
+        total_stats.accumulate(current_stats);
+        if (stats_callback) {
+            stats_callback(current_stats);
+        }
+        current_stats = parse_stats{};
+        stats_active = false;
+    }
+
+    /// @brief 进行中的这一次解析
+    parse_stats current_stats{};
+    /// @brief 累计值，不含每个选项的统计(保存在选项中)
+    parse_stats total_stats{};
+    bool stats_active{false};
+    std::uint64_t allocations_begin{0};
+    std::function<void(const parse_stats &)> stats_callback{};
+#endif
+
+    /// @brief 缓存的一次解析结果
+    struct cache_entry
+    {
+        /// @brief 原始输入
+        std::string key;
+        /// @brief serialize() 的结果
+        std::string value;
+        /// @brief 最近一次使用的时刻
+        std::uint64_t used;
+    };
+
+    /// @brief 缓存容量，为0时不缓存
+    std::size_t cache_capacity{0};
+    std::vector<cache_entry> cache_entries{};
+    /// @brief 与 cache_entries 对齐的键的哈希值，连续存放以便扫描
+    std::vector<std::uint64_t> cache_hashes{};
+    /// @brief 本次解析的键和哈希值
+    std::string cache_key{};
+    std::uint64_t cache_hash{0};
+    /// @brief 本次解析调用了有副作用的 reader
+    bool cache_skip{false};
+    std::uint64_t cache_tick{0};
+    std::uint64_t cache_hit_count{0};
+    std::uint64_t cache_miss_count{0};
+
+    /// @brief 推迟执行的 reader 调用
+    struct deferred_call
+    {
+        option_base *option;
+        /// @brief 指向 argv 中的值
+        const char *value;
+        /// @brief 失败时错误信息在 errors 中的位置
+        std::size_t error_pos;
+        /// @brief 同一个选项的下一次调用
+        std::size_t next;
+        bool ok;
+        /// @brief reader 抛出的 std::exception 以外的异常
+        std::exception_ptr thrown;
+    };
+
+    static const std::size_t npos = static_cast<std::size_t>(-1);
+
+    executor *exec{nullptr};
+    /// @brief 按参数顺序排列的推迟的调用
+    std::vector<deferred_call> deferred{};
+    /// @brief 每个任务的第一次调用，一个选项一个任务
+    std::vector<std::size_t> deferred_tasks{};
+
+    /// @brief serialize() 的格式标识："CMD"、格式版本1和字节序标记
+    static const std::uint64_t serial_magic = 0x0102030401444d43ULL;
+
+    /// @brief 缓存的选项定义指纹
+    mutable std::uint64_t spec_hash{0};
+    mutable bool spec_dirty{true};
+
+    /// @brief 选项是否被设置，按添加顺序每个选项一位
+    std::vector<std::uint64_t> set_bits{};
+    /// @brief 必填的选项，与 set_bits 对齐
+    std::vector<std::uint64_t> required_bits{};
+
+    std::vector<constraint> constraints{};
+    std::vector<mask_word> constraint_words{};
+
+    /// @brief 按选项名排序的索引，用于二分查找
+    std::vector<option_base *> index{};
+    /// @brief 按添加顺序存储的所有选项，负责析构
+    std::vector<option_base *> ordered{};
+    /// @brief 脚注
+    std::string ftr{};
+
+    /// @brief 用于展示的可执行文件名
+    std::string prog_name{};
+    /// @brief 使用帮助中默认值最多显示的字符数，0 表示不限制
+    std::size_t default_width{0};
+    /// @brief 其余参数
+    std::vector<std::string> others{};
+    /// @brief 本次解析得到的其余参数个数
+    std::size_t rest_count{0};
+    /// @brief 按添加顺序存储的位置参数，负责析构
+    std::vector<positional_base *> positionals{};
+    /// @brief 下一个要绑定的位置参数
+    std::size_t positional_next{0};
+
+    /// @brief parse(const std::string &) 的分词缓冲区
+    std::vector<std::string> tokens{};
+    /// @brief 传给 parse(int, const char *const[]) 的参数指针
+    std::vector<const char *> argv_buf{};
+
+    /// @brief 错误信息
+    std::vector<std::string> errors{};
+};
+
+}  // namespace cmdline
@@ -0,0 +1,158 @@
+/// @file handoff.h
+/// @author moth (QianMoth@qq.com)
+/// @brief 把解析结果交给子进程
+/// @details
+/// 启动器解析完命令行后用 save() 把 parser::serialize() 的结果写入文件或继承的文件描述符，
+/// 子进程用 load() 通过 mmap 读取并恢复，不需要重新分词和转换；选项定义不一致时 load_or_parse() 回退到正常解析。
+/// 依赖 POSIX 接口。
+///
+/// @copyright Copyright (c) 2009, Hideyuki Tanaka
+///
+#pragma once
+
+#include "core.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <string>
+
+namespace cmdline {
+
+namespace handoff {
+
+/// @brief 把解析结果写入文件描述符
+/// @param[in] p
+/// @param[in] fd 写入后不关闭
+/// @return bool
+inline bool save(const parser &p, int fd)
+{
+    std::string data;
+    if (!p.serialize(data)) {
+        return false;
+    }
+    std::size_t done = 0;
+    while (done < data.size()) {
+        ssize_t const n = ::write(fd, data.data() + done, data.size() - done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        done += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+/// @brief 把解析结果写入文件
+/// @param[in] p
+/// @param[in] path
+/// @return bool
+inline bool save(const parser &p, const std::string &path)
+{
+    int const fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return false;
+    }
+    bool const ok = save(p, fd);
+    return ::close(fd) == 0 && ok;
+}
+
+/// @brief 创建一个保存解析结果、可以被子进程继承的文件描述符
+/// @details 文件已被删除，只通过描述符访问；描述符没有 FD_CLOEXEC，fork/exec 后在子进程中保持打开，
+/// 可以把它的值通过参数或环境变量告诉子进程
+/// @param[in] p
+/// @return int 失败时为-1
+inline int make_fd(const parser &p)
+{
+    char path[] = "/tmp/cmdline-handoff-XXXXXX";
+    int const fd = ::mkstemp(path);
+    if (fd < 0) {
+        return -1;
+    }
+    ::unlink(path);
+    if (!save(p, fd) || ::lseek(fd, 0, SEEK_SET) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/// @brief 从文件描述符恢复解析结果
+/// @details 普通文件通过 mmap 读取，不支持 mmap 时(例如管道)退回 read()
+/// @param[out] p 与保存时的选项定义相同的解析器
+/// @param[in] fd 读取后不关闭，也不改变文件偏移
+/// @return bool 选项定义不一致或数据不完整时为false
+inline bool load(parser &p, int fd)
+{
+    struct stat st
+    {
+    };
+    if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        std::size_t const size = static_cast<std::size_t>(st.st_size);
+        if (size == 0) {
+            return false;
+        }
+        void *addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            bool const ok = p.deserialize(static_cast<const char *>(addr), size);
+            ::munmap(addr, size);
+            return ok;
+        }
+    }
+
+    std::string data;
+    char buf[4096];
+    while (true) {
+        ssize_t const n = ::read(fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            if (n < 0) {
+                return false;
+            }
+            break;
+        }
+        data.append(buf, static_cast<std::size_t>(n));
+    }
+    return p.deserialize(data);
+}
+
+/// @brief 从文件恢复解析结果
+/// @param[out] p
+/// @param[in] path
+/// @return bool
+inline bool load(parser &p, const std::string &path)
+{
+    int const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    bool const ok = load(p, fd);
+    ::close(fd);
+    return ok;
+}
+
+/// @brief 优先从文件描述符恢复，失败时正常解析命令行
+/// @param[out] p
+/// @param[in] fd 为负数时直接解析
+/// @param[in] argc
+/// @param[in] argv
+/// @return bool 解析结果是否有效
+inline bool load_or_parse(parser &p, int fd, int argc, const char *const argv[])
+{
+    if (fd >= 0 && load(p, fd)) {
+        return p.error().empty();
+    }
+    return p.parse(argc, argv);
+}
+
+}  // namespace handoff
+
+}  // namespace cmdline
@@ -0,0 +1,140 @@
+/// @file parallel.h
+/// @author moth (QianMoth@qq.com)
+/// @brief 并行调用 reader 的线程池
+/// @details
+/// 解析器扫描完参数后，把标记为 independent() 的 reader 按选项分组交给执行器。
+/// thread_pool 是一个固定大小的执行器，调用 run() 的线程也参与执行。
+///
+/// @copyright Copyright (c) 2009, Hideyuki Tanaka
+///
+#pragma once
+
+#include "core.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cmdline {
+
+/// @brief 固定大小的线程池
+/// @code
+/// ```cpp
+/// cmdline::thread_pool pool(4);
+/// a.add<std::string>("key", 'k', "key file", false, "", load_key);
+/// a.independent("key");
+/// a.set_executor(&pool);
+/// a.parse_check(argc, argv);
+/// ```
+/// @endcode
+class thread_pool : public executor
+{
+  public:
+    /// @brief 构造
+    /// @param threads 后台线程数，调用 run() 的线程另外参与执行
+    explicit thread_pool(std::size_t threads)
+    {
+        workers.reserve(threads);
+        for (std::size_t i = 0; i < threads; i++) {
+            workers.emplace_back([this] { work_loop(); });
+        }
+    }
+
+    thread_pool(const thread_pool &) = delete;
+    thread_pool &operator=(const thread_pool &) = delete;
+
+    ~thread_pool() override
+    {
+        {
+            std::lock_guard<std::mutex> const lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto &t : workers) {
+            t.join();
+        }
+    }
+
+    /// @brief 后台线程数
+    std::size_t size() const { return workers.size(); }
+
+    /// @brief 执行一批任务，多个线程同时调用时依次执行
+    void run(std::size_t n, void (*fn)(void *context, std::size_t i), void *context) override
+    {
+        std::lock_guard<std::mutex> const serial(running);
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            // 上一批中醒得晚的线程还拿着旧任务，等它们离开后再发布新任务
+            done.wait(lock, [this] { return active == 0; });
+            task = fn;
+            task_context = context;
+            task_count = n;
+            next.store(0, std::memory_order_relaxed);
+            generation++;
+        }
+        wake.notify_all();
+
+        drain(fn, context, n);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return active == 0; });
+    }
+
+  private:
+    /// @brief 领取并执行任务，直到没有剩余
+    void drain(void (*fn)(void *, std::size_t), void *context, std::size_t n)
+    {
+        for (std::size_t i = next.fetch_add(1); i < n; i = next.fetch_add(1)) {
+            fn(context, i);
+        }
+    }
+
+    void work_loop()
+    {
+        std::uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+            void (*const fn)(void *, std::size_t) = task;
+            void *const context = task_context;
+            std::size_t const n = task_count;
+            active++;
+            lock.unlock();
+
+            drain(fn, context, n);
+
+            lock.lock();
+            if (--active == 0) {
+                done.notify_all();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers{};
+    /// @brief 保证同一时刻只有一批任务
+    std::mutex running{};
+
+    std::mutex mutex{};
+    std::condition_variable wake{};
+    std::condition_variable done{};
+    bool stopping{false};
+    std::uint64_t generation{0};
+    /// @brief 正在执行当前这批任务的后台线程数
+    std::size_t active{0};
+
+    void (*task)(void *, std::size_t){nullptr};
+    void *task_context{nullptr};
+    std::size_t task_count{0};
+    /// @brief 下一个待领取的任务
+    std::atomic<std::size_t> next{0};
+};
+
+}  // namespace cmdline
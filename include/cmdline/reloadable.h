@@ -0,0 +1,233 @@
+/// @file reloadable.h
+/// @author moth (QianMoth@qq.com)
+/// @brief 可热加载的配置
+/// @details
+/// 长期运行的服务在收到 SIGHUP 或管理命令时重新解析选项，同时工作线程仍在读取。
+/// reloadable 每次都用同一份选项定义构造一个新的 parser 并解析，成功后整体发布为不可变的快照；
+/// 正在使用旧快照的读者不受影响。读者不加锁，每个读者公布自己可能还在使用的最旧版本，
+/// 发布新快照时回收所有读者都已经换走的旧快照(基于纪元的回收)。
+/// flat_map 中的键和 string_ref 类型的值是指向解析时参数的视图，因此参数列表会拷贝一份随快照保存。
+///
+/// @copyright Copyright (c) 2009, Hideyuki Tanaka
+///
+#pragma once
+
+#include "core.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace cmdline {
+
+/// @brief 可热加载的配置
+/// @code
+/// ```cpp
+/// cmdline::reloadable config([](cmdline::parser &p) {
+///     p.add<int>("workers", 'w', "worker count", false, 4);
+/// });
+/// config.reload(argc, argv);
+///
+/// // 每个工作线程持有一个 reader
+/// cmdline::reloadable::reader r(config);
+/// int const workers = r.get()->get<int>("workers");
+///
+/// // 收到 SIGHUP 后
+/// if (!config.reload(line)) { log(config.error()); }
+/// ```
+/// @endcode
+class reloadable
+{
+  public:
+    /// @brief 在空的解析器上添加所有选项
+    typedef std::function<void(parser &)> spec_fn;
+    /// @brief 发布后不再修改的解析结果
+    typedef std::shared_ptr<const parser> snapshot;
+
+    /// @brief 读者
+    /// @details 每个线程持有自己的 reader，不能拷贝，也不能比 reloadable 活得更久。
+    /// get() 是无等待的：配置没有变化时只读取一次原子版本号；版本号变化后先公布新的版本号，再读取快照指针，
+    /// 都不加锁，也不修改引用计数。reader 返回的快照在下一次 get() 或 reader 析构之前一直有效。
+    /// 长时间不调用 get() 的读者会让它之后发布的旧快照都不能回收，空闲的线程应当析构自己的 reader。
+    class reader
+    {
+      public:
+        explicit reader(const reloadable &owner) : owner(&owner)
+        {
+            std::lock_guard<std::mutex> const lock(owner.mutex);
+            owner.readers.push_back(&pinned);
+        }
+
+        reader(const reader &) = delete;
+        reader &operator=(const reader &) = delete;
+
+        ~reader()
+        {
+            std::lock_guard<std::mutex> const lock(owner->mutex);
+            for (std::size_t i = 0; i < owner->readers.size(); i++) {
+                if (owner->readers[i] == &pinned) {
+                    owner->readers[i] = owner->readers.back();
+                    owner->readers.pop_back();
+                    break;
+                }
+            }
+            owner->reclaim();
+        }
+
+        /// @brief 当前的快照
+        /// @return const parser* 还没有成功加载过时为nullptr
+        const parser *get()
+        {
+            std::uint64_t const v = owner->published.load();
+            if (v != seen) {
+                // 先公布版本号再读取指针：发布者要么看到这个版本号而保留新快照，
+                // 要么在读者读取指针之前已经换上了更新的快照，回收的只会是更旧的
+                pinned.store(v);
+                const holder *h = owner->head.load();
+                snap = &h->p;
+                seen = h->version;
+                pinned.store(seen);
+            }
+            return snap;
+        }
+
+        /// @brief 当前快照的版本号
+        std::uint64_t version() const { return seen; }
+
+      private:
+        const reloadable *owner;
+        std::uint64_t seen{0};
+        const parser *snap{nullptr};
+        /// @brief 可能还在使用的最旧版本，0 表示没有持有快照
+        std::atomic<std::uint64_t> pinned{0};
+    };
+
+    explicit reloadable(spec_fn spec) : spec(std::move(spec)) {}
+    reloadable(const reloadable &) = delete;
+    reloadable &operator=(const reloadable &) = delete;
+
+    /// @brief 解析字符串并发布新快照
+    /// @param[in] arg
+    /// @return bool 解析失败时保留原快照，错误信息见 error()
+    bool reload(const std::string &arg)
+    {
+        // 分词结果保存在 parser 内部，不需要另外保存参数
+        return publish([&arg](holder &h) { return h.p.parse(arg); });
+    }
+
+    /// @brief 解析参数列表并发布新快照
+    /// @param[in] args
+    /// @return bool
+    bool reload(const std::vector<std::string> &args)
+    {
+        return publish([&args](holder &h) {
+            h.args = args;
+            return h.p.parse(h.args);
+        });
+    }
+
+    /// @brief 解析命令行并发布新快照
+    /// @param[in] argc
+    /// @param[in] argv
+    /// @return bool
+    bool reload(int argc, const char *const argv[])
+    {
+        return publish([argc, argv](holder &h) {
+            h.args.assign(argv, argv + argc);
+            return h.p.parse(h.args);
+        });
+    }
+
+    /// @brief 当前快照，不加锁，但要修改引用计数，频繁读取时使用 reader
+    /// @return snapshot 还没有成功加载过时为空
+    snapshot current() const { return std::atomic_load(&latest); }
+
+    /// @brief 已发布的版本号，每次成功加载加一，从未加载时为0
+    std::uint64_t version() const { return published.load(std::memory_order_acquire); }
+
+    /// @brief 最近一次失败的加载的错误信息
+    std::string error() const
+    {
+        std::lock_guard<std::mutex> const lock(mutex);
+        return last_error;
+    }
+
+  private:
+    /// @brief 快照中的解析器和它的视图所指向的参数
+    struct holder
+    {
+        parser p;
+        std::vector<std::string> args;
+        std::uint64_t version{0};
+    };
+
+    /// @brief 在新的解析器上解析，成功后发布
+    template <class F>
+    bool publish(F parse)
+    {
+        // 构造和解析都在锁外进行，只有发布需要加锁
+        std::shared_ptr<holder> next = std::make_shared<holder>();
+        spec(next->p);
+        bool const ok = parse(*next);
+
+        std::lock_guard<std::mutex> const lock(mutex);
+        if (!ok) {
+            last_error = next->p.error_full();
+            return false;
+        }
+        next->version = published.load() + 1;
+        if (current_holder) {
+            retired.push_back(std::move(current_holder));
+        }
+        // 先换指针再增加版本号，看到新版本号的读者一定读到不旧于它的快照
+        head.store(next.get());
+        published.store(next->version);
+        // 快照与参数共用引用计数，参数和解析器一起释放
+        std::atomic_store(&latest, snapshot(next, &next->p));
+        current_holder = std::move(next);
+        reclaim();
+        return true;
+    }
+
+    /// @brief 释放所有读者都已经换走的旧快照，调用时持有锁
+    void reclaim() const
+    {
+        std::uint64_t oldest = published.load();
+        for (const std::atomic<std::uint64_t> *pin : readers) {
+            std::uint64_t const v = pin->load();
+            if (v != 0 && v < oldest) {
+                oldest = v;
+            }
+        }
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < retired.size(); i++) {
+            if (retired[i]->version >= oldest) {
+                retired[kept++] = std::move(retired[i]);
+            }
+        }
+        retired.resize(kept);
+    }
+
+    spec_fn spec;
+
+    /// @brief 保护发布、回收、读者列表和 last_error，读者的 get() 不使用
+    mutable std::mutex mutex{};
+    /// @brief 通过 atomic_load/atomic_store 访问
+    snapshot latest{};
+    std::string last_error{};
+    /// @brief 最新的快照，读者在锁外读取
+    std::atomic<const holder *> head{nullptr};
+    /// @brief 最新快照的版本号，在 head 之后更新
+    std::atomic<std::uint64_t> published{0};
+    std::shared_ptr<holder> current_holder{};
+    /// @brief 已被替换、可能还有读者在使用的快照
+    mutable std::vector<std::shared_ptr<holder>> retired{};
+    /// @brief 每个读者公布的版本号
+    mutable std::vector<const std::atomic<std::uint64_t> *> readers{};
+};
+
+}  // namespace cmdline
@@ -0,0 +1,564 @@
+/// @file server.h
+/// @author moth (QianMoth@qq.com)
+/// @brief 事件驱动的多会话命令服务器
+/// @details
+/// 在 Unix 域套接字或本地 TCP 上接受连接，用 epoll 非阻塞地读取每个会话发来的行，
+/// 按同一份选项定义解析后交给处理函数。所有会话在一个线程中处理，不为每个连接创建线程。
+/// 依赖 Linux 接口 (epoll、eventfd)。
+///
+/// @copyright Copyright (c) 2009, Hideyuki Tanaka
+///
+#pragma once
+
+#include "core.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace cmdline {
+
+/// @brief 命令服务器
+/// @details
+/// 每个会话按行发送命令，一行是一条命令(不含程序名，结尾的"\r"会被去掉，连接关闭前最后一行可以没有换行)。
+/// 服务器把它交给共享的 parser 解析，
+/// 然后调用处理函数，处理函数通过 session::write() 回复。选项定义在构造时建立，之后只用于解析；
+/// 会话自己的状态(读写缓冲区、命令计数、context)各自独立。
+/// 同一时刻只处理一行，传给处理函数的 parser 被所有会话共用，只在处理函数返回前有效。
+/// 每个会话另外保存自己最近一条命令的结果(session::flags()、session::result())，不受其他会话的命令影响。
+/// @code
+/// ```cpp
+/// cmdline::server srv(
+///     [](cmdline::parser &p) { p.add<std::string>("host", 0, "host name", true, ""); },
+///     [](cmdline::server::session &s, const cmdline::parser &p, bool ok) {
+///         s.write((ok ? p.get<std::string>("host") : p.error()) + "\n");
+///     });
+/// srv.listen_unix("/tmp/ops.sock");
+/// srv.run();
+/// ```
+/// @endcode
+class server
+{
+  public:
+    /// @brief 一个连接
+    class session
+    {
+      public:
+        /// @brief 连接的编号，从1开始递增，不会复用
+        std::uint64_t id() const { return serial; }
+
+        /// @brief 套接字
+        int fd() const { return sock; }
+
+        /// @brief 已经处理的命令数
+        std::uint64_t commands() const { return count; }
+
+        /// @brief 追加要发送的数据，处理函数返回后统一发送
+        /// @param data
+        /// @param size
+        void write(const char *data, std::size_t size) { out.append(data, size); }
+
+        /// @brief 追加要发送的数据
+        /// @param data
+        void write(const std::string &data) { out += data; }
+
+        /// @brief 发送完已有的数据后关闭连接，之后收到的命令不再处理
+        void close() { closing = true; }
+
+        /// @brief 本会话最近一条命令设置的选项，与 parser::flags() 相同
+        const flag_set &flags() const { return last_flags; }
+
+        /// @brief 本会话最近一条命令的解析结果，parser::serialize() 的编码
+        /// @details 用同样的选项定义构造的 parser 调用 deserialize() 即可恢复，包括错误信息。
+        /// 设置了不能编码的选项时为空，还没有处理过命令时也为空
+        const std::string &result() const { return last_result; }
+
+        /// @brief 本会话最近一条命令是否解析成功
+        bool ok() const { return last_ok; }
+
+        /// @brief 应用自己的会话状态，关闭时由 set_close_handler() 设置的回调释放
+        void *context{nullptr};
+
+      private:
+        friend class server;
+
+        int sock{-1};
+        std::uint64_t serial{0};
+        std::uint64_t count{0};
+        /// @brief 还没有处理的输入
+        std::string in{};
+        /// @brief 等待发送的输出，已发送到 sent
+        std::string out{};
+        std::size_t sent{0};
+        /// @brief 当前在 epoll 中关注的事件
+        std::uint32_t events{0};
+        bool closing{false};
+        /// @brief 最近一条命令的结果，空间在命令之间复用
+        flag_set last_flags{};
+        std::string last_result{};
+        bool last_ok{false};
+    };
+
+    /// @brief 在空的解析器上添加所有选项
+    typedef std::function<void(parser &)> spec_fn;
+    /// @brief 处理一条命令，ok 为解析结果
+    typedef std::function<void(session &, const parser &, bool ok)> handler_fn;
+    /// @brief 会话建立或关闭
+    typedef std::function<void(session &)> session_fn;
+
+    /// @brief 构造
+    /// @param spec 选项定义，只调用一次
+    /// @param handler 处理函数
+    server(const spec_fn &spec, handler_fn handler) : handler(std::move(handler))
+    {
+        spec(cmd);
+        epfd = ::epoll_create1(EPOLL_CLOEXEC);
+        wakefd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epfd < 0 || wakefd < 0 || !watch(wakefd, EPOLLIN)) {
+            release();
+            throw cmdline_error(std::string("cannot create event loop: ") + std::strerror(errno));
+        }
+        spare = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+    }
+
+    server(const server &) = delete;
+    server &operator=(const server &) = delete;
+
+    ~server()
+    {
+        for (auto &s : sessions) {
+            if (s) {
+                drop(*s);
+            }
+        }
+        release();
+    }
+
+    /// @brief 在 Unix 域套接字上监听，已存在的同名文件会被删除
+    /// @param path
+    /// @return bool
+    bool listen_unix(const std::string &path)
+    {
+        sockaddr_un addr{};
+        if (path.size() >= sizeof(addr.sun_path)) {
+            errno = ENAMETOOLONG;
+            return false;
+        }
+        addr.sun_family = AF_UNIX;
+        std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+        ::unlink(path.c_str());
+
+        int const fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            return false;
+        }
+        if (!listen_on(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr))) {
+            return false;
+        }
+        unix_paths.push_back(path);
+        return true;
+    }
+
+    /// @brief 在 TCP 端口上监听
+    /// @param host IPv4 地址，例如 "127.0.0.1"
+    /// @param port 为0时由系统分配，之后用 port() 查询
+    /// @return bool
+    bool listen_tcp(const std::string &host, std::uint16_t port)
+    {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        if (::inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+            errno = EINVAL;
+            return false;
+        }
+
+        int const fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            return false;
+        }
+        int const on = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        if (!listen_on(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr))) {
+            return false;
+        }
+
+        socklen_t len = sizeof(addr);
+        if (::getsockname(fd, reinterpret_cast<sockaddr *>(&addr), &len) == 0) {
+            tcp_port = ntohs(addr.sin_port);
+        }
+        return true;
+    }
+
+    /// @brief 最近一次 listen_tcp() 实际监听的端口
+    std::uint16_t port() const { return tcp_port; }
+
+    /// @brief 一行的最大长度，超过时回复错误并关闭连接，默认 64KiB
+    /// @param size
+    void set_max_line(std::size_t size) { max_line = size; }
+
+    /// @brief 等待发送的数据超过这个大小时暂停读取该会话，直到发送完，默认 1MiB
+    /// @param size
+    void set_max_pending(std::size_t size) { max_pending = size; }
+
+    /// @brief 会话建立时调用
+    /// @param f
+    void set_open_handler(session_fn f) { on_open = std::move(f); }
+
+    /// @brief 会话关闭时调用，可以在这里释放 session::context
+    /// @param f
+    void set_close_handler(session_fn f) { on_close = std::move(f); }
+
+    /// @brief 共享的解析器，可以在 run() 之前调整(例如 enable_cache()、footer())
+    parser &spec() { return cmd; }
+
+    /// @brief 当前的会话数
+    std::size_t session_count() const { return active; }
+
+    /// @brief 处理一批就绪的事件
+    /// @param timeout_ms 没有事件时最多等待的毫秒数，-1 表示一直等待
+    /// @return bool 事件循环出错或已经 stop() 时返回 false
+    bool run_once(int timeout_ms)
+    {
+        if (stopped) {
+            return false;
+        }
+        epoll_event events[64];
+        int const n = ::epoll_wait(epfd, events, 64, timeout_ms);
+        if (n < 0) {
+            return errno == EINTR;
+        }
+        for (int i = 0; i < n; i++) {
+            int const fd = static_cast<int>(events[i].data.u64 & 0xffffffffU);
+            if (fd == wakefd) {
+                std::uint64_t value = 0;
+                (void)!::read(wakefd, &value, sizeof(value));
+                stopped = true;
+            } else if (is_listener(fd)) {
+                accept_all(fd);
+            } else if (static_cast<std::size_t>(fd) < sessions.size() && sessions[fd] &&
+                       tag(fd, sessions[fd]->serial) == events[i].data.u64) {
+                serve(*sessions[fd], events[i].events);
+            }
+        }
+        return !stopped;
+    }
+
+    /// @brief 一直处理事件，直到 stop()
+    void run()
+    {
+        while (run_once(-1)) {
+        }
+    }
+
+    /// @brief 让 run() 返回，可以在其他线程或信号处理函数中调用
+    void stop()
+    {
+        std::uint64_t const one = 1;
+        (void)!::write(wakefd, &one, sizeof(one));
+    }
+
+  private:
+    /// @brief 事件数据：低32位是描述符，高32位是会话编号的低位，
+    /// 用来识别同一批事件中已经关闭、描述符又被新连接复用的会话
+    static std::uint64_t tag(int fd, std::uint64_t serial)
+    {
+        return (serial << 32) | static_cast<std::uint32_t>(fd);
+    }
+
+    bool watch(int fd, std::uint32_t events, std::uint64_t serial = 0)
+    {
+        epoll_event ev{};
+        ev.events = events;
+        ev.data.u64 = tag(fd, serial);
+        return ::epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) == 0;
+    }
+
+    bool listen_on(int fd, const sockaddr *addr, socklen_t len)
+    {
+        if (::bind(fd, addr, len) != 0 || ::listen(fd, SOMAXCONN) != 0 || !watch(fd, EPOLLIN)) {
+            int const saved = errno;
+            ::close(fd);
+            errno = saved;
+            return false;
+        }
+        listeners.push_back(fd);
+        return true;
+    }
+
+    bool is_listener(int fd) const
+    {
+        for (int l : listeners) {
+            if (l == fd) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void accept_all(int listener)
+    {
+        while (true) {
+            int const fd = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) {
+                    continue;
+                }
+                if ((errno == EMFILE || errno == ENFILE) && reject(listener)) {
+                    continue;
+                }
+                // EAGAIN 表示已经取完；其他错误留到下次就绪时再试
+                return;
+            }
+            int const on = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));  // Unix 域套接字上会失败，忽略
+
+            if (!watch(fd, EPOLLIN, serial + 1)) {
+                ::close(fd);
+                continue;
+            }
+            if (static_cast<std::size_t>(fd) >= sessions.size()) {
+                sessions.resize(static_cast<std::size_t>(fd) + 1);
+            }
+            std::unique_ptr<session> &s = sessions[fd];
+            s.reset(new session);
+            s->sock = fd;
+            s->serial = ++serial;
+            s->events = EPOLLIN;
+            active++;
+            if (on_open) {
+                on_open(*s);
+            }
+        }
+    }
+
+    /// @brief 描述符用尽时用预留的描述符接受一个连接并立即关闭
+    /// @details 监听套接字是水平触发的，不取走等待中的连接，epoll_wait 会一直返回它，事件循环空转
+    /// @return bool 是否取走了一个连接
+    bool reject(int listener)
+    {
+        if (spare < 0) {
+            return false;
+        }
+        ::close(spare);
+        int const fd = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        spare = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+        return fd >= 0;
+    }
+
+    void serve(session &s, std::uint32_t events)
+    {
+        if ((events & (EPOLLERR | EPOLLHUP)) != 0 && (events & EPOLLIN) == 0) {
+            close_session(s);
+            return;
+        }
+        if ((events & EPOLLIN) != 0 && !receive(s)) {
+            close_session(s);
+            return;
+        }
+        if (!flush(s) || (s.closing && s.sent == s.out.size())) {
+            close_session(s);
+            return;
+        }
+        update(s);
+    }
+
+    /// @brief 读到 EAGAIN 为止，并处理其中完整的行
+    /// @return bool 对端已关闭或出错时返回 false
+    bool receive(session &s)
+    {
+        bool eof = false;
+        while (!s.closing) {
+            ssize_t const n = ::read(s.sock, chunk, sizeof(chunk));
+            if (n > 0) {
+                s.in.append(chunk, static_cast<std::size_t>(n));
+                dispatch(s);
+                if (s.out.size() - s.sent >= max_pending) {
+                    break;  // 暂停读取，等待发送
+                }
+                continue;
+            }
+            if (n == 0) {
+                eof = true;
+            } else if (errno == EINTR) {
+                continue;
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                return false;
+            }
+            break;
+        }
+        if (eof) {
+            // 最后一行可以没有换行
+            if (!s.closing && !s.in.empty()) {
+                s.in.push_back('\n');
+                dispatch(s);
+            }
+            // 对端不再发送，但还可能在等待回复
+            s.closing = true;
+        }
+        return true;
+    }
+
+    /// @brief 处理输入缓冲区中所有完整的行
+    void dispatch(session &s)
+    {
+        std::size_t begin = 0;
+        while (!s.closing) {
+            std::size_t const end = s.in.find('\n', begin);
+            if (end == std::string::npos) {
+                break;
+            }
+            std::size_t len = end - begin;
+            if (len > 0 && s.in[end - 1] == '\r') {
+                len--;
+            }
+            // 命令中没有程序名，补一个占位的参数
+            line.assign("> ", 2);
+            line.append(s.in, begin, len);
+            bool const ok = cmd.parse(line);
+            s.count++;
+            // 在调用处理函数之前保存，处理函数中 session 与 parser 一致
+            cmd.flags(s.last_flags);
+            s.last_result.clear();
+            cmd.serialize(s.last_result);
+            s.last_ok = ok;
+            handler(s, cmd, ok);
+            begin = end + 1;
+        }
+        s.in.erase(0, begin);
+
+        if (!s.closing && s.in.size() > max_line) {
+            static const char msg[] = "line too long\n";
+            s.write(msg, sizeof(msg) - 1);
+            s.close();
+        }
+    }
+
+    /// @brief 发送到 EAGAIN 为止
+    /// @return bool 出错时返回 false
+    bool flush(session &s)
+    {
+        while (s.sent < s.out.size()) {
+            ssize_t const n = ::send(s.sock, s.out.data() + s.sent, s.out.size() - s.sent, MSG_NOSIGNAL);
+            if (n > 0) {
+                s.sent += static_cast<std::size_t>(n);
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else {
+                return false;
+            }
+        }
+        if (s.sent == s.out.size()) {
+            s.out.clear();
+            s.sent = 0;
+        }
+        return true;
+    }
+
+    /// @brief 按缓冲区状态调整关注的事件：有待发送的数据时关注可写，积压过多或正在关闭时不再关注可读
+    void update(session &s)
+    {
+        std::uint32_t events = 0;
+        if (!s.closing && s.out.size() - s.sent < max_pending) {
+            events |= EPOLLIN;
+        }
+        if (s.sent < s.out.size()) {
+            events |= EPOLLOUT;
+        }
+        if (events != s.events) {
+            epoll_event ev{};
+            ev.events = events;
+            ev.data.u64 = tag(s.sock, s.serial);
+            ::epoll_ctl(epfd, EPOLL_CTL_MOD, s.sock, &ev);
+            s.events = events;
+        }
+    }
+
+    void close_session(session &s)
+    {
+        int const fd = s.sock;
+        drop(s);
+        sessions[fd].reset();
+    }
+
+    void drop(session &s)
+    {
+        if (on_close) {
+            on_close(s);
+        }
+        ::epoll_ctl(epfd, EPOLL_CTL_DEL, s.sock, nullptr);
+        ::close(s.sock);
+        active--;
+    }
+
+    void release()
+    {
+        for (int fd : listeners) {
+            ::close(fd);
+        }
+        listeners.clear();
+        for (const auto &path : unix_paths) {
+            ::unlink(path.c_str());
+        }
+        unix_paths.clear();
+        if (wakefd >= 0) {
+            ::close(wakefd);
+        }
+        if (spare >= 0) {
+            ::close(spare);
+        }
+        if (epfd >= 0) {
+            ::close(epfd);
+        }
+        wakefd = -1;
+        epfd = -1;
+        spare = -1;
+    }
+
+    parser cmd{};
+    handler_fn handler;
+    session_fn on_open{};
+    session_fn on_close{};
+
+    int epfd{-1};
+    /// @brief stop() 通过它唤醒 epoll_wait
+    int wakefd{-1};
+    /// @brief 预留的描述符，描述符用尽时腾出来拒绝连接
+    int spare{-1};
+    std::vector<int> listeners{};
+    std::vector<std::string> unix_paths{};
+    std::uint16_t tcp_port{0};
+
+    /// @brief 按套接字编号索引的会话
+    std::vector<std::unique_ptr<session>> sessions{};
+    std::size_t active{0};
+    std::uint64_t serial{0};
+    bool stopped{false};
+
+    std::size_t max_line{64 * 1024};
+    std::size_t max_pending{1024 * 1024};
+    /// @brief 解析用的行缓冲区，在所有会话之间复用
+    std::string line{};
+    char chunk[16 * 1024]{};
+};
+
+}  // namespace cmdline
@@ -0,0 +1,210 @@
+/// @file trace.h
+/// @author moth (QianMoth@qq.com)
+/// @brief 解析统计的导出
+/// @details
+/// 需要对整个程序定义 `CMDLINE_ENABLE_STATS`。
+/// 提供把 parse_stats 输出为JSON的 write_json()，以及按间隔采样并导出 Chrome trace 的 stats_sampler，
+/// 导出的文件可以用 chrome://tracing 或 Perfetto 打开。
+///
+/// @copyright Copyright (c) 2009, Hideyuki Tanaka
+///
+#pragma once
+
+#ifndef CMDLINE_ENABLE_STATS
+#error "cmdline/trace.h requires CMDLINE_ENABLE_STATS to be defined for the whole program"
+#endif
+
+#include "core.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace cmdline {
+
+namespace detail {
+
+/// @brief 输出JSON字符串，转义引号、反斜杠和控制字符
+inline void write_json_string(std::ostream &os, const std::string &s)
+{
+    os << '"';
+    for (char const c : s) {
+        if (c == '"' || c == '\\') {
+            os << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(c));
+            os << buf;
+        } else {
+            os << c;
+        }
+    }
+    os << '"';
+}
+
+inline void write_json_phase(std::ostream &os, const char *name, const phase_stats &phase)
+{
+    os << '"' << name << "\": {\"count\": " << phase.count << ", \"ns\": " << phase.ns << '}';
+}
+
+/// @brief 输出一个 Chrome trace 的完整事件(ph = X)
+inline void write_trace_event(std::ostream &os, bool &first, const std::string &name, std::uint64_t begin_ns,
+                              std::uint64_t dur_ns, std::uint64_t count)
+{
+    os << (first ? "\n    " : ",\n    ");
+    first = false;
+    os << "{\"name\": ";
+    write_json_string(os, name);
+    os << ", \"cat\": \"cmdline\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1, \"ts\": " << begin_ns / 1000 << '.'
+       << begin_ns % 1000 / 100 << begin_ns % 100 / 10 << begin_ns % 10 << ", \"dur\": " << dur_ns / 1000 << '.'
+       << dur_ns % 1000 / 100 << dur_ns % 100 / 10 << dur_ns % 10 << ", \"args\": {\"count\": " << count << "}}";
+}
+
+}  // namespace detail
+
+/// @brief 以JSON格式输出统计
+/// @param os
+/// @param stats
+inline void write_json(std::ostream &os, const parse_stats &stats)
+{
+    os << "{\"parses\": " << stats.parses << ", \"allocations\": " << stats.allocations << ",\n ";
+    detail::write_json_phase(os, "registration", stats.registration);
+    os << ",\n ";
+    detail::write_json_phase(os, "tokenize", stats.tokenize);
+    os << ",\n ";
+    detail::write_json_phase(os, "total", stats.total);
+    os << ",\n ";
+    detail::write_json_phase(os, "reset", stats.reset);
+    os << ",\n ";
+    detail::write_json_phase(os, "short_table", stats.short_table);
+    os << ",\n ";
+    detail::write_json_phase(os, "long_lookup", stats.long_lookup);
+    os << ",\n ";
+    detail::write_json_phase(os, "reader", stats.reader);
+    os << ",\n ";
+    detail::write_json_phase(os, "required", stats.required);
+    os << ",\n \"options\": [";
+    for (std::size_t i = 0; i < stats.options.size(); i++) {
+        os << (i ? ",\n  " : "\n  ") << "{\"name\": ";
+        detail::write_json_string(os, stats.options[i].name);
+        os << ", \"count\": " << stats.options[i].reader.count << ", \"ns\": " << stats.options[i].reader.ns << '}';
+    }
+    os << "]}\n";
+}
+
+/// @brief 按固定间隔采样每次解析的统计，并导出为 Chrome trace
+/// @code
+/// ```cpp
+/// cmdline::stats_sampler sampler(10);  // 每10次解析采样一次
+/// sampler.attach(parser);
+/// ...
+/// std::ofstream out("parse.trace.json");
+/// sampler.write_chrome_trace(out);
+/// ```
+/// @endcode
+class stats_sampler
+{
+  public:
+    /// @param every 每隔多少次解析采样一次
+    /// @param capacity 最多保留的样本数，之后的样本被丢弃
+    explicit stats_sampler(std::uint64_t every = 1, std::size_t capacity = 4096)
+        : every(every ? every : 1), capacity(capacity)
+    {
+    }
+
+    /// @brief 注册为解析器的统计回调，会替换已有的回调
+    /// @param p 生命周期不能长于本对象
+    void attach(parser &p)
+    {
+        p.set_stats_callback([this](const parse_stats &stats) { record(stats); });
+    }
+
+    /// @brief 记录一次解析的统计
+    /// @param stats
+    void record(const parse_stats &stats)
+    {
+        if (seen++ % every != 0) {
+            return;
+        }
+        if (data.size() >= capacity) {
+            dropped++;
+            return;
+        }
+        data.push_back(stats);
+    }
+
+    const std::vector<parse_stats> &samples() const { return data; }
+
+    /// @brief 超出容量而丢弃的样本数
+    std::uint64_t dropped_samples() const { return dropped; }
+
+    void clear()
+    {
+        data.clear();
+        seen = 0;
+        dropped = 0;
+    }
+
+    /// @brief 导出为 Chrome trace 事件格式
+    /// @details
+    /// 每次解析是一个 parse 事件；分词、重置、短选项表、必填检查按实际顺序排列。
+    /// 长选项查找和 reader 穿插在参数循环中，这里按累计耗时依次排列，并附带调用次数。
+    /// @param os
+    void write_chrome_trace(std::ostream &os) const
+    {
+        os << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+        bool first = true;
+        for (const auto &s : data) {
+            std::uint64_t const begin = s.begin_ns;
+            std::uint64_t const end = begin + s.total.ns;
+            detail::write_trace_event(os, first, "parse", begin, s.total.ns, s.parses);
+
+            std::uint64_t t = begin;
+            const struct
+            {
+                const char *name;
+                const phase_stats &phase;
+                bool per_option;
+            } sequential[] = {{"tokenize", s.tokenize, false},
+                              {"reset", s.reset, false},
+                              {"short_table", s.short_table, false},
+                              {"long_lookup", s.long_lookup, false},
+                              {"reader", s.reader, true}};
+            for (const auto &item : sequential) {
+                if (item.phase.count == 0) {
+                    continue;
+                }
+                detail::write_trace_event(os, first, item.name, t, item.phase.ns, item.phase.count);
+                if (item.per_option) {
+                    // 每个选项的 reader 嵌套在 reader 阶段中
+                    std::uint64_t o = t;
+                    for (const auto &option : s.options) {
+                        detail::write_trace_event(os, first, "reader --" + option.name, o, option.reader.ns,
+                                                  option.reader.count);
+                        o += option.reader.ns;
+                    }
+                }
+                t += item.phase.ns;
+            }
+            if (s.required.count != 0) {
+                detail::write_trace_event(os, first, "required", end - s.required.ns, s.required.ns,
+                                          s.required.count);
+            }
+
+            os << ",\n    {\"name\": \"allocations\", \"ph\": \"C\", \"pid\": 1, \"tid\": 1, \"ts\": " << begin / 1000
+               << ", \"args\": {\"allocations\": " << s.allocations << "}}";
+        }
+        os << "\n]}\n";
+    }
+
+  private:
+    std::uint64_t every;
+    std::size_t capacity;
+    std::uint64_t seen{0};
+    std::uint64_t dropped{0};
+    std::vector<parse_stats> data{};
+};
+
+}  // namespace cmdline
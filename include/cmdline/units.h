@@ -0,0 +1,458 @@
+/// @file units.h
+/// @author moth (QianMoth@qq.com)
+/// @brief 带单位的数值：字节数、时长和速率
+/// @details
+/// `512MiB`、`250ms`、`1h30m`、`10k/s` 这样的值在参数的视图上一遍读完，不分配内存，
+/// 按有理数精确换算到目标类型，溢出或不能精确表示时视为不合法。
+/// unit_reader 可以带上下界，下界和上界同样用带单位的文本给出。
+/// 包含本文件后，std::chrono::duration 也可以直接作为选项类型，与 range() 组合使用。
+///
+/// @copyright Copyright (c) 2009, Hideyuki Tanaka
+///
+#pragma once
+
+#include "core.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+
+namespace cmdline {
+
+namespace detail {
+
+inline bool mul_u64(std::uint64_t a, std::uint64_t b, std::uint64_t &out)
+{
+    if (a != 0 && b > std::numeric_limits<std::uint64_t>::max() / a) {
+        return false;
+    }
+    out = a * b;
+    return true;
+}
+
+inline std::uint64_t gcd_u64(std::uint64_t a, std::uint64_t b)
+{
+    while (b != 0) {
+        std::uint64_t const t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/// @brief 既约分数 num/den 乘以 n/d，先约分再相乘，结果仍是既约分数
+inline bool mul_ratio(std::uint64_t &num, std::uint64_t &den, std::uint64_t n, std::uint64_t d)
+{
+    std::uint64_t const g = gcd_u64(n, d);
+    n /= g;
+    d /= g;
+    std::uint64_t const g1 = gcd_u64(num, d);
+    std::uint64_t const g2 = gcd_u64(n, den);
+    return mul_u64(num / g1, n / g2, num) && mul_u64(den / g2, d / g1, den);
+}
+
+/// @brief 以 num/den 为单位的十进制数 mantissa/scale，与目标单位之比为 num/den
+struct unit_value
+{
+    std::uint64_t mantissa;
+    std::uint64_t scale;
+    std::uint64_t num;
+    std::uint64_t den;
+};
+
+/// @brief 读取非负十进制数，小数部分最多18位
+/// @param[in,out] first 移到数字之后
+/// @return bool 没有数字或溢出时为false
+inline bool read_decimal(const char *&first, const char *last, std::uint64_t &mantissa, std::uint64_t &scale)
+{
+    mantissa = 0;
+    scale = 1;
+    bool digits = false;
+    bool point = false;
+    for (; first != last; ++first) {
+        if (*first == '.' && !point) {
+            point = true;
+            continue;
+        }
+        unsigned const d = static_cast<unsigned char>(*first) - static_cast<unsigned>('0');
+        if (d > 9) {
+            break;
+        }
+        if (point && !mul_u64(scale, 10, scale)) {
+            return false;
+        }
+        if (!mul_u64(mantissa, 10, mantissa) || mantissa > std::numeric_limits<std::uint64_t>::max() - d) {
+            return false;
+        }
+        mantissa += d;
+        digits = true;
+    }
+    return digits;
+}
+
+/// @brief 把 v 精确换算到整数或浮点类型 T
+template <class T>
+typename std::enable_if<std::is_integral<T>::value, bool>::type to_unit(const unit_value &v, T &out)
+{
+    std::uint64_t num = v.num;
+    std::uint64_t den = v.den;
+    if (!mul_ratio(num, den, 1, v.scale)) {
+        return false;
+    }
+    std::uint64_t const g = gcd_u64(v.mantissa, den);
+    std::uint64_t result = 0;
+    if (den / g != 1 || !mul_u64(v.mantissa / g, num, result) ||
+        result > static_cast<std::uint64_t>(std::numeric_limits<T>::max())) {
+        return false;
+    }
+    out = static_cast<T>(result);
+    return true;
+}
+
+template <class T>
+typename std::enable_if<std::is_floating_point<T>::value, bool>::type to_unit(const unit_value &v, T &out)
+{
+    out = static_cast<T>(static_cast<long double>(v.mantissa) / static_cast<long double>(v.scale) *
+                         static_cast<long double>(v.num) / static_cast<long double>(v.den));
+    return true;
+}
+
+/// @brief 时间单位，以秒为单位的比值
+struct time_unit
+{
+    const char *suffix;
+    std::uint64_t num;
+    std::uint64_t den;
+};
+
+inline const time_unit *time_units()
+{
+    // 长的后缀在前，"ms" 和 "min" 先于 "m" 匹配
+    static const time_unit units[] = {
+        {"ns", 1, 1000000000},  {"us", 1, 1000000}, {"\xC2\xB5s", 1, 1000000}, {"ms", 1, 1000}, {"min", 60, 1},
+        {"s", 1, 1},            {"m", 60, 1},       {"h", 3600, 1},           {"d", 86400, 1}, {nullptr, 0, 0},
+    };
+    return units;
+}
+
+/// @brief 在 [first, last) 开头匹配时间单位
+inline const time_unit *match_time_unit(const char *&first, const char *last)
+{
+    for (const time_unit *u = time_units(); u->suffix != nullptr; u++) {
+        std::size_t const n = std::strlen(u->suffix);
+        if (static_cast<std::size_t>(last - first) >= n && std::memcmp(first, u->suffix, n) == 0) {
+            first += n;
+            return u;
+        }
+    }
+    return nullptr;
+}
+
+/// @brief 字节数：`B`，十进制的 `k`、`M`、`G`、`T`、`P`、`E`(可加 `B`)，二进制的 `Ki`、`Mi`...(可加 `B`)
+/// @details 数值和单位之间可以有空白(`512 MiB`)，其他位置不能有，`"1 "` 不合法
+struct byte_units
+{
+    template <class T>
+    static bool read(const char *first, const char *last, T &out)
+    {
+        unit_value v{0, 1, 1, 1};
+        if (!read_decimal(first, last, v.mantissa, v.scale)) {
+            return false;
+        }
+        // 数值和单位之间可以有空白，单位之后和没有单位时不能有
+        const char *const number_end = first;
+        while (first != last && is_space(*first)) {
+            ++first;
+        }
+        if (first == last && first != number_end) {
+            return false;
+        }
+        if (first != last && *first != 'B') {
+            unsigned power = 0;
+            switch (*first) {
+                case 'k':
+                case 'K':
+                    power = 1;
+                    break;
+                case 'M':
+                    power = 2;
+                    break;
+                case 'G':
+                    power = 3;
+                    break;
+                case 'T':
+                    power = 4;
+                    break;
+                case 'P':
+                    power = 5;
+                    break;
+                case 'E':
+                    power = 6;
+                    break;
+                default:
+                    return false;
+            }
+            ++first;
+            std::uint64_t base = 1000;
+            if (first != last && *first == 'i') {
+                base = 1024;
+                ++first;
+            }
+            for (unsigned i = 0; i < power; i++) {
+                v.num *= base;
+            }
+        }
+        if (first != last && *first == 'B') {
+            ++first;
+        }
+        return first == last && to_unit(v, out);
+    }
+};
+
+/// @brief 时长：`ns`、`us`、`ms`、`s`、`m`/`min`、`h`、`d`，可以连写(`1h30m`)；没有单位时是目标类型的单位
+template <class D>
+struct duration_units
+{
+    static bool read(const char *first, const char *last, D &out)
+    {
+        typedef typename D::rep rep;
+        typedef typename D::period period;
+        rep total = rep();
+        bool any = false;
+        while (first != last) {
+            unit_value v{0, 1, 1, 1};
+            if (!read_decimal(first, last, v.mantissa, v.scale)) {
+                return false;
+            }
+            const time_unit *const u = match_time_unit(first, last);
+            if (u == nullptr) {
+                // 没有单位只能单独出现
+                if (any || first != last) {
+                    return false;
+                }
+            } else if (!mul_ratio(v.num, v.den, u->num * static_cast<std::uint64_t>(period::den),
+                                  u->den * static_cast<std::uint64_t>(period::num))) {
+                return false;
+            }
+            rep part = rep();
+            if (!to_unit(v, part) || part > std::numeric_limits<rep>::max() - total) {
+                return false;
+            }
+            total += part;
+            any = true;
+        }
+        if (!any) {
+            return false;
+        }
+        out = D(total);
+        return true;
+    }
+};
+
+/// @brief 速率，每秒的个数：可选的 `k`、`M`、`G`、`T` 加上可选的 `/s`、`/ms`、`/min`、`/h` 等；没有时间单位时按每秒
+struct rate_units
+{
+    template <class T>
+    static bool read(const char *first, const char *last, T &out)
+    {
+        unit_value v{0, 1, 1, 1};
+        if (!read_decimal(first, last, v.mantissa, v.scale)) {
+            return false;
+        }
+        if (first != last && *first != '/') {
+            switch (*first) {
+                case 'k':
+                case 'K':
+                    v.num = 1000;
+                    break;
+                case 'M':
+                    v.num = 1000000;
+                    break;
+                case 'G':
+                    v.num = 1000000000;
+                    break;
+                case 'T':
+                    v.num = 1000000000000;
+                    break;
+                default:
+                    return false;
+            }
+            ++first;
+        }
+        if (first != last) {
+            if (*first != '/') {
+                return false;
+            }
+            ++first;
+            const time_unit *const u = match_time_unit(first, last);
+            if (u == nullptr || first != last || !mul_ratio(v.num, v.den, u->den, u->num)) {
+                return false;
+            }
+        }
+        return to_unit(v, out);
+    }
+};
+
+/// @brief 时长按能整除的最大单位输出
+template <class Rep, class Period>
+std::string duration_to_string(const std::chrono::duration<Rep, Period> &d, std::true_type /*integral*/)
+{
+    static const char *const largest_first[] = {"d", "h", "min", "s", "ms", "us", "ns"};
+    bool const neg = d.count() < 0;
+    std::uint64_t const count =
+        neg ? 0 - static_cast<std::uint64_t>(d.count()) : static_cast<std::uint64_t>(d.count());
+    char buf[48];
+    if (count == 0) {
+        return "0s";
+    }
+    for (const char *suffix : largest_first) {
+        const char *p = suffix;
+        const time_unit *const u = match_time_unit(p, suffix + std::strlen(suffix));
+        unit_value v{count, 1, 1, 1};
+        std::uint64_t n = 0;
+        if (mul_ratio(v.num, v.den, static_cast<std::uint64_t>(Period::num) * u->den,
+                      static_cast<std::uint64_t>(Period::den) * u->num) &&
+            to_unit(v, n)) {
+            std::snprintf(buf, sizeof(buf), "%s%llu%s", neg ? "-" : "", static_cast<unsigned long long>(n), suffix);
+            return buf;
+        }
+    }
+    // 比纳秒更小的单位，不带单位输出
+    std::snprintf(buf, sizeof(buf), "%s%llu", neg ? "-" : "", static_cast<unsigned long long>(count));
+    return buf;
+}
+
+template <class Rep, class Period>
+std::string duration_to_string(const std::chrono::duration<Rep, Period> &d, std::false_type /*integral*/)
+{
+    char buf[48];
+    std::snprintf(buf, sizeof(buf), "%Lgs",
+                  static_cast<long double>(std::chrono::duration_cast<std::chrono::duration<long double>>(d).count()));
+    return buf;
+}
+
+/// @brief std::chrono::duration 按时长单位转换
+template <class Rep, class Period>
+struct converter<std::chrono::duration<Rep, Period>, void>
+{
+    static bool from_string(const char *first, const char *last, std::chrono::duration<Rep, Period> &out)
+    {
+        return duration_units<std::chrono::duration<Rep, Period>>::read(first, last, out);
+    }
+
+    static std::string to_string(const std::chrono::duration<Rep, Period> &v)
+    {
+        return duration_to_string(v, std::is_integral<Rep>());
+    }
+};
+
+template <class Rep, class Period>
+struct type_name<std::chrono::duration<Rep, Period>, void>
+{
+    static std::string get() { return "duration"; }
+};
+
+}  // namespace detail
+
+/// @brief 带单位的数值
+/// @tparam T 目标类型
+/// @tparam Units 单位规则，detail::byte_units、detail::duration_units<T> 或 detail::rate_units
+template <class T, class Units>
+struct unit_reader
+{
+    unit_reader() = default;
+    unit_reader(const T &low, const T &high) : low(low), high(high), bounded(true) {}
+
+    /// @brief 下界和上界用带单位的文本给出
+    unit_reader(const char *low, const char *high) : bounded(true)
+    {
+        if (!Units::read(low, low + std::strlen(low), this->low)) {
+            throw cmdline_error(std::string("invalid bound: ") + low);
+        }
+        if (!Units::read(high, high + std::strlen(high), this->high)) {
+            throw cmdline_error(std::string("invalid bound: ") + high);
+        }
+    }
+
+    T operator()(const std::string &s) const
+    {
+        T ret;
+        if (!read(s.data(), s.data() + s.size(), ret)) {
+            throw std::bad_cast();
+        }
+        return ret;
+    }
+
+    /// @brief 在视图上转换，失败时 out 不变
+    bool read(const char *first, const char *last, T &out) const
+    {
+        T value = T();
+        if (!Units::read(first, last, value) || !contains(value)) {
+            return false;
+        }
+        out = value;
+        return true;
+    }
+
+    bool contains(const T &v) const { return !bounded || (!(v < low) && !(high < v)); }
+
+  private:
+    T low{};
+    T high{};
+    bool bounded{false};
+};
+
+/// @brief 字节数，例如 `512MiB`、`1.5GB`、`4096`
+template <class T = std::uint64_t>
+unit_reader<T, detail::byte_units> byte_size()
+{
+    return unit_reader<T, detail::byte_units>();
+}
+
+/// @brief 字节数，限制在 [low, high] 内，例如 byte_size("1MiB", "64GiB")
+template <class T = std::uint64_t>
+unit_reader<T, detail::byte_units> byte_size(const char *low, const char *high)
+{
+    return unit_reader<T, detail::byte_units>(low, high);
+}
+
+/// @brief 时长，例如 `250ms`、`1h30m`
+template <class D>
+unit_reader<D, detail::duration_units<D>> duration()
+{
+    return unit_reader<D, detail::duration_units<D>>();
+}
+
+/// @brief 时长，限制在 [low, high] 内，例如 duration<std::chrono::milliseconds>("1ms", "30s")
+template <class D>
+unit_reader<D, detail::duration_units<D>> duration(const char *low, const char *high)
+{
+    return unit_reader<D, detail::duration_units<D>>(low, high);
+}
+
+/// @brief 时长，限制在 [low, high] 内，例如 duration<std::chrono::milliseconds>(std::chrono::seconds(1), ...)
+template <class D>
+unit_reader<D, detail::duration_units<D>> duration(const D &low, const D &high)
+{
+    return unit_reader<D, detail::duration_units<D>>(low, high);
+}
+
+/// @brief 每秒的速率，例如 `10k/s`、`600/min`
+template <class T = double>
+unit_reader<T, detail::rate_units> rate()
+{
+    return unit_reader<T, detail::rate_units>();
+}
+
+/// @brief 每秒的速率，限制在 [low, high] 内，例如 rate("1/s", "10k/s")
+template <class T = double>
+unit_reader<T, detail::rate_units> rate(const char *low, const char *high)
+{
+    return unit_reader<T, detail::rate_units>(low, high);
+}
+
+}  // namespace cmdline
@@ -0,0 +1,134 @@
+/// @file usage.h
+/// @author Hideyuki Tanaka, moth (QianMoth@qq.com)
+/// @brief 使用帮助和 parse_check()
+/// @details
+/// parser::usage() 拼接帮助文本，parser::parse_check() 在出错或指定了 --help 时通过 `<cstdio>` 输出帮助并退出程序。
+/// 它们在 core.h 中声明、在这里定义，只需要解析和读取结果的翻译单元不必包含这部分。cmdline.h 已包含本文件。
+///
+/// @copyright Copyright (c) 2009, Hideyuki Tanaka
+///
+#pragma once
+
+#include "core.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace cmdline {
+
+/// @brief 使用帮助
+/// @return std::string
+inline std::string parser::usage() const
+{
+    std::string ret;
+    ret += "usage: " + prog_name + " ";
+    for (auto *i : ordered) {
+        if (i->must()) {
+            ret += i->short_description() + " ";
+        }
+    }
+
+    ret += "[options] ";
+    bool variadic = false;
+    for (auto *arg : positionals) {
+        switch (arg->count()) {
+            case arity::single:
+                ret += arg->name() + " ";
+                break;
+            case arity::optional:
+                ret += "[" + arg->name() + "] ";
+                break;
+            case arity::variadic:
+                ret += "[" + arg->name() + "...] ";
+                variadic = true;
+                break;
+        }
+    }
+    ret += (variadic ? "" : "... ") + ftr + "\n";
+    ret += "options:\n";
+
+    size_t max_width = 0;
+    for (auto *i : ordered) {
+        max_width = max_width < i->name().length() ? i->name().length() : max_width;
+    }
+    for (auto *i : ordered) {
+        if (i->short_name()) {
+            ret += "  -";
+            ret += i->short_name();
+            ret += ", ";
+        } else {
+            ret += "      ";
+        }
+
+        ret += "--" + i->name();
+        ret.append(max_width + 4 - i->name().length(), ' ');
+        ret += i->description(default_width) + "\n";
+    }
+
+    if (!positionals.empty()) {
+        ret += "arguments:\n";
+        max_width = 0;
+        for (auto *arg : positionals) {
+            max_width = max_width < arg->name().length() ? arg->name().length() : max_width;
+        }
+        for (auto *arg : positionals) {
+            ret += "  " + arg->name();
+            ret.append(max_width + 4 - arg->name().length(), ' ');
+            ret += arg->description(default_width) + "\n";
+        }
+    }
+    return ret;
+}
+
+/// @brief 检查解析器设置是否正确
+/// @param arg
+inline void parser::parse_check(const std::string &arg)
+{
+    if (find("help", 4) == nullptr) {
+        add("help", 'h', "print this message");
+    }
+    check(0, parse(arg));
+}
+
+/// @brief 检查解析器设置是否正确
+/// @param args
+inline void parser::parse_check(const std::vector<std::string> &args)
+{
+    if (find("help", 4) == nullptr) {
+        add("help", 'h', "print this message");
+    }
+    check((int)args.size(), parse(args));
+}
+
+/// @brief 检查解析器设置是否正确
+/// @param argc 参数个数
+/// @param argv
+inline void parser::parse_check(int argc, char *argv[])
+{
+    if (find("help", 4) == nullptr) {  // 如果不存在help选项自己创建一个
+        add("help", 'h', "print this message");
+    }
+    check(argc, parse(argc, argv));
+}
+
+/// @brief 检查
+/// @details 通过 `<cstdio>` 输出，核心部分不依赖 `<iostream>`
+/// @param argc
+/// @param ok
+inline void parser::check(int argc, bool ok) const
+{
+    if ((argc == 1 && !ok) || exist("help")) {
+        std::fputs(usage().c_str(), stdout);
+        std::exit(0);
+    }
+
+    if (!ok) {
+        std::fputs((error() + "\n").c_str(), stderr);
+        std::fputs(usage().c_str(), stdout);
+        std::exit(1);
+    }
+}
+
+}  // namespace cmdline
@@ -0,0 +1,54 @@
+/// @file alloc.cpp
+/// @brief 稳态零分配：同样形状的输入解析过一次后，再次解析不调用 operator new
+#include <cmdline/core.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../benchmark/alloc_count.h"
+#include "check.h"
+
+namespace {
+
+void add_options(cmdline::parser &p)
+{
+    p.add<std::string>("host", 0, "host name", true, "");
+    p.add<int>("port", 'p', "port number", false, 80, cmdline::range(1, 65535));
+    p.add<std::string>("type", 't', "protocol type", false, "http",
+                       cmdline::oneof<std::string>("http", "https", "ssh", "ftp"));
+    p.add<double>("ratio", 'r', "ratio", false, 0.5);
+    p.add("gzip", 'g', "gzip when transfer");
+    p.add("verbose", 'v', "verbose");
+}
+
+/// @brief 先解析一次预热，之后每次解析都不能分配
+template <class F>
+void check_steady(F parse_once)
+{
+    CHECK(parse_once());
+    std::uint64_t const before = bench::allocation_count();
+    for (int i = 0; i < 100; i++) {
+        parse_once();
+    }
+    CHECK(bench::allocation_count() == before);
+}
+
+}  // namespace
+
+int main()
+{
+    cmdline::parser p;
+    add_options(p);
+
+    const char *const argv[] = {"prog", "--host=github.com", "-p", "8080", "--type", "https",
+                                "-r",   "0.25",              "-gv", "file1", "file2"};
+    check_steady([&] { return p.parse(11, argv); });
+
+    std::string const line = "prog --host=github.com -p 8080 --type \"https\" -r 0.25 -gv file\\ one.txt file2.txt";
+    check_steady([&] { return p.parse(line); });
+
+    std::vector<std::string> const args = {"prog", "--host=github.com", "-p", "8080", "-gv", "file1"};
+    check_steady([&] { return p.parse(args); });
+    return 0;
+}
@@ -0,0 +1,146 @@
+/// @file cache.cpp
+/// @brief 解析缓存的命中计数、LRU 淘汰、no_cache 和失败结果
+#include <cmdline/core.h>
+
+#include <string>
+
+#include "check.h"
+
+namespace {
+
+/// @brief 记录调用次数的 reader
+struct counting_reader
+{
+    int *calls;
+
+    int operator()(const std::string &s) const
+    {
+        ++*calls;
+        return std::stoi(s);
+    }
+};
+
+void add_options(cmdline::parser &p)
+{
+    p.add<int>("port", 'p', "port number", false, 80);
+    p.add<std::string>("host", 0, "host name", false, "localhost");
+    p.add("verbose", 'v', "verbose");
+}
+
+void check_counts_and_lru()
+{
+    cmdline::parser p;
+    add_options(p);
+    p.enable_cache(2);
+
+    CHECK(p.parse("prog -p 1 a"));
+    CHECK(p.cache_hits() == 0 && p.cache_misses() == 1);
+    CHECK(p.parse("prog -p 1 a"));
+    CHECK(p.cache_hits() == 1 && p.cache_misses() == 1);
+    CHECK(p.get<int>("port") == 1);
+    CHECK(p.rest().size() == 1 && p.rest()[0] == "a");
+
+    // 字符串和 argv 输入的键互不相同
+    const char *const argv[] = {"prog", "-p", "1", "a"};
+    CHECK(p.parse(4, argv));
+    CHECK(p.cache_hits() == 1 && p.cache_misses() == 2);
+    CHECK(p.parse(4, argv));
+    CHECK(p.cache_hits() == 2);
+
+    // 容量为2，最近使用的是 argv 那一项，新结果淘汰字符串那一项
+    CHECK(p.parse("prog -p 2"));
+    CHECK(p.cache_misses() == 3);
+    CHECK(p.parse(4, argv));
+    CHECK(p.cache_hits() == 3);
+    CHECK(p.parse("prog -p 1 a"));
+    CHECK(p.cache_hits() == 3 && p.cache_misses() == 4);
+    CHECK(p.get<int>("port") == 1);
+
+    // 刚才淘汰的是 "prog -p 2"，argv 那一项比它新
+    CHECK(p.parse(4, argv));
+    CHECK(p.cache_hits() == 4);
+    CHECK(p.parse("prog -p 2"));
+    CHECK(p.cache_hits() == 4 && p.cache_misses() == 5);
+    CHECK(p.get<int>("port") == 2);
+    CHECK(p.rest().empty());
+}
+
+void check_no_cache()
+{
+    int calls = 0;
+    cmdline::parser p;
+    add_options(p);
+    p.add<int>("count", 'c', "count", false, 0, counting_reader{&calls});
+    p.no_cache("count");
+    p.enable_cache(8);
+
+    for (int i = 0; i < 3; i++) {
+        CHECK(p.parse("prog -c 5"));
+        CHECK(p.get<int>("count") == 5);
+    }
+    CHECK(calls == 3);
+    CHECK(p.cache_hits() == 0);
+
+    // 没有设置这个选项的结果照常缓存
+    CHECK(p.parse("prog -p 8"));
+    CHECK(p.parse("prog -p 8"));
+    CHECK(p.cache_hits() == 1);
+    CHECK(p.get<int>("count") == 0);
+    CHECK(calls == 3);
+
+    CHECK_THROWS(p.no_cache("unknown"));
+}
+
+void check_failure_cached()
+{
+    cmdline::parser p;
+    add_options(p);
+    p.enable_cache(8);
+
+    for (int i = 0; i < 2; i++) {
+        CHECK(!p.parse("prog -p abc"));
+        CHECK(p.error() == "option value is invalid: --port=abc");
+        CHECK(p.get<int>("port") == 80);
+    }
+    CHECK(p.cache_hits() == 1 && p.cache_misses() == 1);
+
+    // 命中失败结果之后，成功的结果没有残留的错误
+    CHECK(p.parse("prog -p 9"));
+    CHECK(p.error().empty());
+    CHECK(!p.parse("prog -p abc"));
+    CHECK(p.cache_hits() == 2);
+    CHECK(p.error() == "option value is invalid: --port=abc");
+}
+
+void check_add_clears()
+{
+    cmdline::parser p;
+    add_options(p);
+    p.enable_cache(8);
+
+    CHECK(p.parse("prog -v"));
+    CHECK(p.parse("prog -v"));
+    CHECK(p.cache_hits() == 1);
+
+    p.add<int>("retries", 'r', "retries", false, 3);
+    CHECK(p.parse("prog -v"));
+    CHECK(p.cache_hits() == 1 && p.cache_misses() == 2);
+    CHECK(p.get<int>("retries") == 3);
+
+    // 关闭缓存后不再查找
+    p.enable_cache(0);
+    CHECK(p.parse("prog -v"));
+    CHECK(p.parse("prog -v"));
+    CHECK(p.cache_hits() == 1 && p.cache_misses() == 2);
+}
+
+}  // namespace
+
+int main()
+{
+    check_counts_and_lru();
+    check_no_cache();
+    check_failure_cached();
+    check_add_clears();
+    return 0;
+}
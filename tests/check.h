@@ -0,0 +1,30 @@
+/// @file check.h
+/// @brief 测试用的断言，失败时打印位置并以非零值退出
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+
+#define CHECK(cond)                                                                    \
+    do {                                                                               \
+        if (!(cond)) {                                                                 \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            std::exit(1);                                                              \
+        }                                                                              \
+    } while (0)
+
+/// @brief 表达式必须抛出 std::exception 派生的异常
+#define CHECK_THROWS(expr)                                                             \
+    do {                                                                               \
+        bool thrown_ = false;                                                          \
+        try {                                                                          \
+            expr;                                                                      \
+        } catch (const std::exception & /*e*/) {                                       \
+            thrown_ = true;                                                            \
+        }                                                                              \
+        if (!thrown_) {                                                                \
+            std::fprintf(stderr, "%s:%d: CHECK_THROWS failed: %s\n", __FILE__, __LINE__, #expr); \
+            std::exit(1);                                                              \
+        }                                                                              \
+    } while (0)
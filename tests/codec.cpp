@@ -0,0 +1,135 @@
+/// @file codec.cpp
+/// @brief 只有 operator<< 的类型配合自己的 reader 可以作为选项，只是不能编码；类型也不必能默认构造
+#include <cmdline/batch.h>
+#include <cmdline/cmdline.h>
+#include <cmdline/parallel.h>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "check.h"
+
+namespace {
+
+/// @brief 没有 operator>>
+struct point
+{
+    int x;
+    int y;
+};
+
+std::ostream &operator<<(std::ostream &os, const point &p)
+{
+    return os << p.x << ',' << p.y;
+}
+
+struct point_reader
+{
+    point operator()(const std::string &s) const
+    {
+        std::string::size_type const comma = s.find(',');
+        if (comma == std::string::npos) {
+            throw cmdline::cmdline_error("bad point: " + s);
+        }
+        return point{std::stoi(s.substr(0, comma)), std::stoi(s.substr(comma + 1))};
+    }
+};
+
+/// @brief 不能默认构造
+struct level
+{
+    explicit level(int v) : v(v) {}
+    int v;
+};
+
+std::ostream &operator<<(std::ostream &os, const level &l)
+{
+    return os << 'L' << l.v;
+}
+
+struct level_reader
+{
+    level operator()(const std::string &s) const { return level(std::stoi(s)); }
+};
+
+void add_options(cmdline::parser &p)
+{
+    p.add<point>("origin", 'o', "origin", false, point{0, 0}, point_reader());
+    p.add<int>("port", 'p', "port number", false, 80);
+}
+
+}  // namespace
+
+int main()
+{
+    static_assert(!cmdline::detail::codec<point>::supported, "point has no operator>>");
+    static_assert(cmdline::detail::codec<int>::supported, "");
+    static_assert(cmdline::detail::codec<std::string>::supported, "");
+
+    cmdline::parser a;
+    add_options(a);
+    CHECK(a.usage().find("[=0,0]") != std::string::npos);
+
+    cmdline::parser l;
+    l.add<level>("level", 'l', "level", false, level(3), level_reader());
+    CHECK(l.usage().find("[=L3]") != std::string::npos);
+    CHECK(l.parse("prog -l 5"));
+    CHECK(l.get<level>("level").v == 5);
+    CHECK(l.parse("prog"));
+    CHECK(l.get<level>("level").v == 3);
+
+    // 没有设置不能编码的选项时照常编码
+    std::string data;
+    CHECK(a.parse("prog -p 8080"));
+    CHECK(a.serialize(data));
+
+    data.clear();
+    CHECK(a.parse("prog --origin=3,4"));
+    CHECK(a.get<point>("origin").y == 4);
+    CHECK(!a.serialize(data));
+    CHECK(data.empty());
+    CHECK(a.serialize().empty());
+
+    // 缓存不保存这样的结果，每次都重新解析
+    a.enable_cache(8);
+    for (int i = 0; i < 3; i++) {
+        CHECK(a.parse("prog --origin=5,6"));
+        CHECK(a.get<point>("origin").x == 5);
+        CHECK(a.parse("prog -p 1"));
+        CHECK(a.get<point>("origin").x == 0);
+    }
+    CHECK(a.cache_hits() == 2);
+
+    // 按序交付时不能编码的结果重新解析
+    std::string lines;
+    for (int i = 0; i < 200; i++) {
+        lines += i % 2 == 0 ? "prog --origin=" + std::to_string(i) + ",0\n" : "prog -p " + std::to_string(i) + "\n";
+    }
+    cmdline::thread_pool pool(2);
+    cmdline::batch b(add_options, &pool, pool.size() + 1, true);
+    b.set_chunk_lines(4);
+    std::vector<int> seen;
+    b.parse_many(lines.data(), lines.size(), [&](std::size_t line, const cmdline::parser &p, bool ok) {
+        CHECK(ok);
+        seen.push_back(static_cast<int>(line));
+        if (line % 2 == 0) {
+            CHECK(p.get<point>("origin").x == static_cast<int>(line));
+        } else {
+            CHECK(p.get<int>("port") == static_cast<int>(line));
+        }
+    });
+    CHECK(seen.size() == 200);
+    for (std::size_t i = 0; i < seen.size(); i++) {
+        CHECK(seen[i] == static_cast<int>(i));
+    }
+
+    // 工作槽数默认不超过核数
+    CHECK(b.workers() == 3);
+    unsigned const cores = std::thread::hardware_concurrency();
+    if (cores != 0) {
+        CHECK(cmdline::batch(add_options, &pool, cores + 1).workers() == cores);
+        CHECK(cmdline::batch(add_options, &pool, 0).workers() == cores);
+    }
+    return 0;
+}
@@ -0,0 +1,135 @@
+/// @file constraint.cpp
+/// @brief 选项之间的约束：错误信息、超过64个选项的位图，以及与必填选项的配合
+#include <cmdline/core.h>
+
+#include <string>
+
+#include "check.h"
+
+namespace {
+
+void add_options(cmdline::parser &p)
+{
+    p.add("tls", 0, "use tls");
+    p.add<std::string>("tls-cert", 0, "certificate", false, "");
+    p.add<std::string>("tls-key", 0, "private key", false, "");
+    p.add("quiet", 'q', "quiet");
+    p.add("verbose", 'v', "verbose");
+    p.add("debug", 'd', "debug");
+    p.add("tcp", 0, "tcp");
+    p.add("udp", 0, "udp");
+    p.add("unix", 0, "unix socket");
+    p.depends_on("tls-cert", {"tls-key", "tls"});
+    p.conflicts_with("quiet", {"verbose", "debug"});
+    p.exactly_one_of({"tcp", "udp", "unix"});
+}
+
+void check_messages()
+{
+    cmdline::parser p;
+    add_options(p);
+
+    CHECK(p.parse("prog --tcp"));
+    CHECK(p.parse("prog --udp --tls-cert=a --tls-key=b --tls -q"));
+
+    // 只列出缺少的依赖，按添加顺序
+    CHECK(!p.parse("prog --tcp --tls-cert=a --tls"));
+    CHECK(p.error() == "option --tls-cert requires --tls-key");
+    CHECK(!p.parse("prog --tcp --tls-cert=a"));
+    CHECK(p.error() == "option --tls-cert requires --tls, --tls-key");
+    // 默认值不算设置
+    CHECK(p.parse("prog --tcp --tls-key=b"));
+
+    // 只列出冲突的选项
+    CHECK(!p.parse("prog --tcp -qd"));
+    CHECK(p.error() == "option --quiet conflicts with --debug");
+    CHECK(!p.parse("prog --tcp -qvd"));
+    CHECK(p.error() == "option --quiet conflicts with --verbose, --debug");
+    CHECK(p.parse("prog --tcp -vd"));
+
+    CHECK(!p.parse("prog"));
+    CHECK(p.error() == "need one of: --tcp, --udp, --unix");
+    CHECK(!p.parse("prog --unix --tcp"));
+    CHECK(p.error() == "options are mutually exclusive: --tcp, --unix");
+
+    // 每个违反的约束各报告一次
+    CHECK(!p.parse("prog --tls-cert=a -qv"));
+    std::string const full = p.error_full();
+    CHECK(full.find("option --tls-cert requires --tls, --tls-key\n") != std::string::npos);
+    CHECK(full.find("option --quiet conflicts with --verbose\n") != std::string::npos);
+    CHECK(full.find("need one of: --tcp, --udp, --unix\n") != std::string::npos);
+
+    // 约束中的选项必须已经添加，名字列表不能为空
+    CHECK_THROWS(p.depends_on("tls", {"missing"}));
+    CHECK_THROWS(p.conflicts_with("missing", {"tls"}));
+    CHECK_THROWS(p.exactly_one_of({}));
+}
+
+void check_wide()
+{
+    // 130 个选项，约束涉及多个字
+    cmdline::parser p;
+    for (int i = 0; i < 130; i++) {
+        p.add("o" + std::to_string(i), 0, "option " + std::to_string(i));
+    }
+    p.depends_on("o3", {"o70", "o129"});
+    p.conflicts_with("o128", {"o1", "o65", "o127"});
+    p.exactly_one_of({"o10", "o64", "o100"});
+
+    CHECK(p.parse("prog --o64"));
+    CHECK(p.parse("prog --o100 --o3 --o70 --o129"));
+    CHECK(!p.parse("prog --o100 --o3 --o70"));
+    CHECK(p.error() == "option --o3 requires --o129");
+    CHECK(!p.parse("prog --o10 --o3"));
+    CHECK(p.error() == "option --o3 requires --o70, --o129");
+
+    CHECK(p.parse("prog --o10 --o128 --o2 --o66"));
+    CHECK(!p.parse("prog --o10 --o128 --o65 --o127"));
+    CHECK(p.error() == "option --o128 conflicts with --o65, --o127");
+
+    CHECK(!p.parse("prog --o1"));
+    CHECK(p.error() == "need one of: --o10, --o64, --o100");
+    CHECK(!p.parse("prog --o100 --o10"));
+    CHECK(p.error() == "options are mutually exclusive: --o10, --o100");
+    CHECK(!p.parse("prog --o64 --o100"));
+    CHECK(p.error() == "options are mutually exclusive: --o64, --o100");
+
+    // 约束之后添加的选项不影响已有的约束
+    p.add("late", 0, "late");
+    CHECK(p.parse("prog --o64 --late"));
+    CHECK(!p.parse("prog --late"));
+    CHECK(p.error() == "need one of: --o10, --o64, --o100");
+}
+
+void check_need()
+{
+    cmdline::parser p;
+    p.add<std::string>("host", 0, "host name", true, "");
+    p.add<int>("port", 'p', "port", true, 0);
+    p.add("tcp", 0, "tcp");
+    p.add("udp", 0, "udp");
+    p.add<std::string>("cert", 0, "certificate", false, "");
+    p.exactly_one_of({"tcp", "udp"});
+    p.depends_on("cert", {"port"});
+
+    // 必填项先于约束报告，两者都列出
+    CHECK(!p.parse("prog --cert=c"));
+    CHECK(p.error() == "need option: --host");
+    CHECK(p.error_full() ==
+          "need option: --host\nneed option: --port\nneed one of: --tcp, --udp\noption --cert requires --port\n");
+
+    // 必填选项也可以出现在约束中，设置后两者都满足
+    CHECK(p.parse("prog --host=h -p 1 --udp --cert=c"));
+    CHECK(!p.parse("prog --host=h -p 1"));
+    CHECK(p.error_full() == "need one of: --tcp, --udp\n");
+}
+
+}  // namespace
+
+int main()
+{
+    check_messages();
+    check_wide();
+    check_need();
+    return 0;
+}
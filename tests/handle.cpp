@@ -0,0 +1,57 @@
+/// @file handle.cpp
+/// @brief 句柄只能用在获取它的 parser 上
+#include <cmdline/core.h>
+
+#include <string>
+
+#include "check.h"
+
+namespace {
+
+template <class F>
+bool throws(F f)
+{
+    try {
+        f();
+    } catch (const cmdline::cmdline_error &) {
+        return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+int main()
+{
+    cmdline::parser a;
+    a.add("gzip", 'g', "gzip when transfer");
+    a.add<std::string>("host", 'h', "host name", false, "localhost");
+
+    cmdline::parser b;
+    b.add<int>("port", 'p', "port number", false, 80);
+    for (int i = 0; i < 100; i++) {
+        b.add("flag-" + std::to_string(i), 0, "");
+    }
+
+    const char *const argv[] = {"prog", "-g", "--host=example.com"};
+    CHECK(a.parse(3, argv));
+
+    cmdline::flag_handle const gzip = a.flag("gzip");
+    cmdline::value_handle<std::string> const host = a.handle<std::string>("host");
+    CHECK(a.exist(gzip));
+    CHECK(a.exist(host));
+    CHECK(a.get(host) == "example.com");
+
+    // 默认构造的句柄
+    CHECK(throws([&] { a.exist(cmdline::flag_handle()); }));
+    CHECK(throws([&] { a.get(cmdline::value_handle<std::string>()); }));
+
+    // 别的 parser 的句柄：同一位置上是另一个选项，或者超出选项个数
+    cmdline::flag_handle const last = b.flag("flag-99");
+    CHECK(throws([&] { a.exist(last); }));
+    CHECK(throws([&] { b.exist(gzip); }));
+    CHECK(throws([&] { b.get(host); }));
+    CHECK(throws([&] { b.take(host); }));
+    CHECK(!b.exist(last));
+    return 0;
+}
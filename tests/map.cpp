@@ -0,0 +1,98 @@
+/// @file map.cpp
+/// @brief 键值对选项：拆分、覆盖、出错时的内容、默认值以及编码后的视图
+#include <cmdline/core.h>
+
+#include <string>
+
+#include "check.h"
+
+namespace {
+
+void add_options(cmdline::parser &p)
+{
+    p.add_map<int>("set", 's', "tunables", cmdline::range(0, 1000));
+    p.add_map<cmdline::string_ref>("define", 'D', "macros");
+}
+
+void check_items()
+{
+    cmdline::parser p;
+    add_options(p);
+
+    CHECK(p.parse("prog --set=b=2,a=1 -s c=3"));
+    const cmdline::flat_map<int> &set = p.get_map<int>("set");
+    CHECK(set.size() == 3);
+    CHECK(set.begin()->first == "a");
+    CHECK(set.at("c") == 3);
+
+    // 同一个键以最后一次为准，无论在同一次还是不同次出现中
+    CHECK(p.parse("prog --set=a=1,a=2 -s b=5 -s a=3"));
+    CHECK(set.size() == 2);
+    CHECK(set.at("a") == 3);
+    CHECK(set.at("b") == 5);
+
+    // 值中可以有等号，键不能为空
+    CHECK(p.parse("prog -D expr=x=y"));
+    CHECK(p.get_map<cmdline::string_ref>("define").at("expr") == "x=y");
+
+    // get() 的默认值，at() 在键不存在时抛出
+    CHECK(set.empty());
+    CHECK(set.get("threads", 4) == 4);
+    CHECK(!set.contains("threads"));
+    CHECK_THROWS(set.at("threads"));
+    CHECK(p.parse("prog -s threads=8"));
+    CHECK(set.get("threads", 4) == 8);
+}
+
+void check_bad_items()
+{
+    cmdline::parser p;
+    add_options(p);
+
+    const char *const bad[] = {"a=1,", ",a=1", "a=1,,b=2", "=1", "a", "a=x", "a=2000"};
+    for (const char *value : bad) {
+        CHECK(!p.parse("prog -s " + std::string(value)));
+        CHECK(p.error() == "option value is invalid: --set=" + std::string(value));
+    }
+
+    // 不合法的出现整体不合并，之前出现的内容保持不变
+    CHECK(!p.parse("prog -s a=1,b=2 -s c=3,a=9,d=x -s e=5"));
+    const cmdline::flat_map<int> &set = p.get_map<int>("set");
+    CHECK(set.size() == 3);
+    CHECK(set.at("a") == 1);
+    CHECK(set.at("b") == 2);
+    CHECK(!set.contains("c"));
+    CHECK(set.at("e") == 5);
+}
+
+void check_deserialize()
+{
+    cmdline::parser p;
+    add_options(p);
+    CHECK(p.parse("prog -D NAME=demo,MODE=fast -s a=1"));
+    std::string data = p.serialize();
+    CHECK(!data.empty());
+
+    cmdline::parser q;
+    add_options(q);
+    CHECK(q.deserialize(data));
+    // 覆盖编码结果和原解析器的缓冲区，恢复出来的视图不能跟着变
+    data.assign(data.size(), '#');
+    CHECK(p.parse("prog -D OTHER=xxxxxxxxxxxxxxxx"));
+
+    const cmdline::flat_map<cmdline::string_ref> &defines = q.get_map<cmdline::string_ref>("define");
+    CHECK(defines.size() == 2);
+    CHECK(defines.at("NAME") == "demo");
+    CHECK(defines.at("MODE") == "fast");
+    CHECK(q.get_map<int>("set").at("a") == 1);
+}
+
+}  // namespace
+
+int main()
+{
+    check_items();
+    check_bad_items();
+    check_deserialize();
+    return 0;
+}
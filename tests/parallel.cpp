@@ -0,0 +1,72 @@
+/// @file parallel.cpp
+/// @brief 交给执行器的 reader 抛出异常时，结果与依次调用相同
+#include <cmdline/core.h>
+#include <cmdline/parallel.h>
+
+#include <stdexcept>
+#include <string>
+
+#include "check.h"
+
+namespace {
+
+/// @brief "bad" 抛出 std::exception，"fatal" 抛出其他异常
+struct throwing_reader
+{
+    int operator()(const std::string &s) const
+    {
+        if (s == "bad") {
+            throw std::runtime_error("bad value");
+        }
+        if (s == "fatal") {
+            throw 42;
+        }
+        return static_cast<int>(s.size());
+    }
+};
+
+void add_options(cmdline::parser &p)
+{
+    p.add<int>("a", 'a', "", false, 0, throwing_reader());
+    p.add<int>("b", 'b', "", false, 0, throwing_reader());
+    p.independent("a");
+    p.independent("b");
+}
+
+int thrown(cmdline::parser &p, const std::string &line)
+{
+    try {
+        p.parse(line);
+    } catch (int e) {
+        return e;
+    }
+    return 0;
+}
+
+}  // namespace
+
+int main()
+{
+    cmdline::thread_pool pool(2);
+    cmdline::parser serial;
+    cmdline::parser parallel;
+    add_options(serial);
+    add_options(parallel);
+    parallel.set_executor(&pool);
+
+    for (cmdline::parser *p : {&serial, &parallel}) {
+        CHECK(p->parse("prog -a xx -b xyz"));
+        CHECK(p->get<int>("a") == 2 && p->get<int>("b") == 3);
+
+        CHECK(!p->parse("prog -a bad -b xyz"));
+        CHECK(p->error_full() == "option value is invalid: --a=bad\n");
+        CHECK(!p->exist("a") && p->exist("b"));
+
+        CHECK(thrown(*p, "prog -a x -b fatal") == 42);
+        CHECK(thrown(*p, "prog -a fatal -b bad") == 42);
+
+        CHECK(p->parse("prog -b x"));
+        CHECK(!p->exist("a") && p->get<int>("b") == 1);
+    }
+    return 0;
+}
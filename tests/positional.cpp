@@ -0,0 +1,126 @@
+/// @file positional.cpp
+/// @brief 位置参数的绑定、默认值、剩余参数、错误信息和注册顺序
+#include <cmdline/core.h>
+#include <cmdline/usage.h>
+
+#include <string>
+#include <vector>
+
+#include "check.h"
+
+namespace {
+
+void add_arguments(cmdline::parser &p)
+{
+    p.add("verbose", 'v', "verbose");
+    p.add_positional<std::string>("input", "input file");
+    p.add_positional<int>("jobs", "worker count", cmdline::arity::optional, 4, cmdline::range(1, 64));
+    p.add_positional<long>("ids", "record ids", cmdline::arity::variadic);
+}
+
+void check_binding()
+{
+    cmdline::parser p;
+    add_arguments(p);
+
+    CHECK(p.parse("prog in.txt 8 1 2 3 -v"));
+    CHECK(p.get_positional<std::string>("input") == "in.txt");
+    CHECK(p.get_positional<int>("jobs") == 8);
+    CHECK(p.get_variadic<long>("ids") == std::vector<long>({1, 2, 3}));
+    CHECK(p.positional_count("ids") == 3);
+    CHECK(p.exist("verbose"));
+    CHECK(p.rest().empty());
+
+    // 省略可选参数时为默认值，剩余参数为空
+    CHECK(p.parse("prog in.txt"));
+    CHECK(p.get_positional<int>("jobs") == 4);
+    CHECK(p.positional_count("jobs") == 0);
+    CHECK(p.get_variadic<long>("ids").empty());
+
+    // 上一次的剩余参数不能残留
+    CHECK(p.parse("prog a 2 7"));
+    CHECK(p.get_variadic<long>("ids") == std::vector<long>({7}));
+    CHECK(p.parse("prog a"));
+    CHECK(p.get_variadic<long>("ids").empty());
+
+    CHECK_THROWS(p.get_positional<std::string>("jobs"));
+    CHECK_THROWS(p.get_positional<int>("unknown"));
+}
+
+void check_errors()
+{
+    cmdline::parser p;
+    add_arguments(p);
+
+    CHECK(!p.parse("prog -v"));
+    CHECK(p.error() == "need argument: input");
+
+    CHECK(!p.parse("prog in.txt x"));
+    CHECK(p.error() == "argument value is invalid: jobs=x");
+    CHECK(!p.parse("prog in.txt 100"));
+    CHECK(p.error() == "argument value is invalid: jobs=100");
+
+    CHECK(!p.parse("prog in.txt 2 1 y 3"));
+    CHECK(p.error() == "argument value is invalid: ids=y");
+}
+
+void check_rest()
+{
+    // 没有剩余参数时，绑定不了的参数进入 rest()
+    cmdline::parser p;
+    p.add_positional<std::string>("input", "input file");
+    p.add_positional<int>("jobs", "worker count", cmdline::arity::optional, 4);
+
+    CHECK(p.parse("prog in.txt 2 extra more"));
+    CHECK(p.get_positional<int>("jobs") == 2);
+    CHECK(p.rest() == std::vector<std::string>({"extra", "more"}));
+    CHECK(p.parse("prog in.txt"));
+    CHECK(p.rest().empty());
+}
+
+void check_usage()
+{
+    cmdline::parser p;
+    add_arguments(p);
+    p.set_program_name("prog");
+    std::string const usage = p.usage();
+    CHECK(usage.find("usage: prog [options] input [jobs] [ids...] \n") == 0);
+    CHECK(usage.find("arguments:\n") != std::string::npos);
+    CHECK(usage.find("worker count (int [=4])") != std::string::npos);
+    CHECK(usage.find("record ids (long ...)") != std::string::npos);
+
+    // 没有剩余参数时仍然提示可以有其他参数
+    cmdline::parser q;
+    q.add_positional<std::string>("input", "input file");
+    q.set_program_name("prog");
+    CHECK(q.usage().find("usage: prog [options] input ... \n") == 0);
+}
+
+void check_order()
+{
+    cmdline::parser p;
+    p.add_positional<std::string>("input", "input file");
+    p.add_positional<int>("jobs", "worker count", cmdline::arity::optional, 4);
+    CHECK_THROWS(p.add_positional<std::string>("output", "output file"));
+    CHECK_THROWS(p.add_positional<int>("jobs", "again", cmdline::arity::optional));
+    p.add_positional<long>("ids", "record ids", cmdline::arity::variadic);
+    CHECK_THROWS(p.add_positional<long>("more", "after variadic", cmdline::arity::optional));
+    CHECK_THROWS(p.add_positional<long>("extra", "second variadic", cmdline::arity::variadic));
+
+    // 被拒绝的注册不改变解析器
+    CHECK(p.parse("prog a 1 2 3"));
+    CHECK(p.get_variadic<long>("ids").size() == 2);
+    CHECK_THROWS(p.positional_count("output"));
+}
+
+}  // namespace
+
+int main()
+{
+    check_binding();
+    check_errors();
+    check_rest();
+    check_usage();
+    check_order();
+    return 0;
+}
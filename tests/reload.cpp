@@ -0,0 +1,131 @@
+/// @file reload.cpp
+/// @brief 快照中的视图不依赖调用者的参数，旧快照的回收，以及读者与重新加载并发时的一致性
+#include <cmdline/reloadable.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+
+namespace {
+
+void spec(cmdline::parser &p)
+{
+    p.add_map<cmdline::string_ref>("define", 'D', "macros");
+}
+
+void pair_spec(cmdline::parser &p)
+{
+    p.add<int>("a", 0, "always equal to b", true, 0);
+    p.add<int>("b", 0, "always equal to a", true, 0);
+}
+
+std::string pair_line(int k)
+{
+    return "prog --a=" + std::to_string(k) + " --b=" + std::to_string(k);
+}
+
+/// @brief 旧快照在持有它的读者换走之后才回收
+void check_reclaim()
+{
+    cmdline::reloadable config(pair_spec);
+    CHECK(config.reload(pair_line(1)));
+    std::weak_ptr<const cmdline::parser> first = config.current();
+    {
+        cmdline::reloadable::reader r(config);
+        CHECK(r.get()->get<int>("a") == 1);
+        CHECK(config.reload(pair_line(2)));
+        CHECK(!first.expired());
+        CHECK(r.get()->get<int>("a") == 2);
+        CHECK(r.version() == 2);
+        CHECK(config.reload(pair_line(3)));
+        CHECK(first.expired());
+    }
+    // 没有读者时下一次发布回收所有旧快照
+    std::weak_ptr<const cmdline::parser> third = config.current();
+    CHECK(config.reload(pair_line(4)));
+    CHECK(third.expired());
+}
+
+/// @brief 多个读者不停读取，同时反复重新加载
+void check_concurrent()
+{
+    const int readers = 4;
+    const int reloads = 2000;
+
+    cmdline::reloadable config(pair_spec);
+    CHECK(config.reload(pair_line(0)));
+
+    std::atomic<bool> stop{false};
+    std::atomic<int> failures{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < readers; t++) {
+        threads.emplace_back([&config, &stop, &failures] {
+            cmdline::reloadable::reader r(config);
+            std::uint64_t last = 0;
+            int last_a = -1;
+            while (!stop.load()) {
+                const cmdline::parser *p = r.get();
+                int const a = p->get<int>("a");
+                if (a != p->get<int>("b") || r.version() < last || (r.version() == last && a != last_a)) {
+                    failures++;
+                }
+                last = r.version();
+                last_a = a;
+            }
+        });
+    }
+    for (int k = 1; k <= reloads; k++) {
+        CHECK(config.reload(pair_line(k)));
+    }
+    stop = true;
+    for (auto &t : threads) {
+        t.join();
+    }
+    CHECK(failures.load() == 0);
+    CHECK(config.version() == static_cast<std::uint64_t>(reloads) + 1);
+    CHECK(config.current()->get<int>("b") == reloads);
+}
+
+}  // namespace
+
+int main()
+{
+    cmdline::reloadable config(spec);
+    {
+        std::vector<std::string> args = {"prog", "-D", "KEY=value-of-key,OTHER=x"};
+        CHECK(config.reload(args));
+        // 覆盖调用者的参数，快照中的内容不能跟着变
+        for (auto &arg : args) {
+            arg.assign(arg.size(), '#');
+        }
+    }
+    {
+        std::string argv0 = "prog", argv1 = "--define=name=from-argv";
+        const char *const argv[] = {argv0.c_str(), argv1.c_str()};
+        cmdline::reloadable other(spec);
+        CHECK(other.reload(2, argv));
+        argv1.assign(argv1.size(), '#');
+        CHECK(other.current()->get_map<cmdline::string_ref>("define").at("name") == "from-argv");
+    }
+
+    cmdline::reloadable::reader r(config);
+    const cmdline::parser *p = r.get();
+    CHECK(p != nullptr);
+    const cmdline::flat_map<cmdline::string_ref> &defines = p->get_map<cmdline::string_ref>("define");
+    CHECK(defines.size() == 2);
+    CHECK(defines.at("KEY") == "value-of-key");
+    CHECK(defines.at("OTHER") == "x");
+
+    // 失败的加载保留原快照
+    CHECK(!config.reload(std::vector<std::string>{"prog", "--unknown"}));
+    CHECK(r.get() == p);
+
+    check_reclaim();
+    check_concurrent();
+    return 0;
+}
@@ -0,0 +1,61 @@
+/// @file serialize.cpp
+/// @brief serialize() 和 deserialize() 的往返，以及损坏的输入
+#include <cmdline/core.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "check.h"
+
+namespace {
+
+void add_options(cmdline::parser &p)
+{
+    p.add<std::string>("host", 'h', "host name", false, "localhost");
+    p.add<int>("port", 'p', "port number", false, 80);
+    p.add("gzip", 'g', "gzip when transfer");
+}
+
+}  // namespace
+
+int main()
+{
+    cmdline::parser a;
+    add_options(a);
+    CHECK(a.parse("prog --host=example.com -p 8080 -g file"));
+    std::string const data = a.serialize();
+
+    cmdline::parser b;
+    add_options(b);
+    CHECK(b.deserialize(data));
+    CHECK(b.get<std::string>("host") == "example.com");
+    CHECK(b.get<int>("port") == 8080);
+    CHECK(b.exist("gzip"));
+    CHECK(b.rest().size() == 1 && b.rest()[0] == "file");
+
+    // 截断在任意位置都要失败
+    for (std::size_t n = 0; n < data.size(); n++) {
+        cmdline::parser c;
+        add_options(c);
+        CHECK(!c.deserialize(data.data(), n));
+        CHECK(c.parse("prog -p 1"));
+        CHECK(c.get<int>("port") == 1);
+    }
+
+    // 位图在魔数、指纹、程序名和字数之后；超出选项个数的位被设置
+    std::size_t const bits_at = 8 + 8 + 8 + std::strlen("prog") + 8;
+    std::string bad = data;
+    std::uint64_t word = 0;
+    std::memcpy(&word, &bad[bits_at], sizeof(word));
+    CHECK(word != 0 && (word >> 63) == 0);
+    word |= std::uint64_t(1) << 63;
+    std::memcpy(&bad[bits_at], &word, sizeof(word));
+    cmdline::parser d;
+    add_options(d);
+    CHECK(!d.deserialize(bad));
+    CHECK(d.parse("prog -g"));
+    CHECK(d.exist("gzip"));
+    CHECK(!d.exist("port"));
+    return 0;
+}
@@ -0,0 +1,180 @@
+/// @file server.cpp
+/// @brief 连接关闭前没有换行的最后一行，每个会话自己的结果，以及描述符用尽时的监听套接字
+#include <cmdline/server.h>
+
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "check.h"
+
+namespace {
+
+int connect_to(const std::string &path, int fd = -1)
+{
+    if (fd < 0) {
+        fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    }
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    CHECK(::connect(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) == 0);
+    return fd;
+}
+
+/// @brief 驱动服务器直到对端关闭连接，返回收到的全部内容
+std::string drain(cmdline::server &srv, int fd)
+{
+    std::string ret;
+    for (int round = 0; round < 1000; round++) {
+        srv.run_once(0);
+        pollfd p{fd, POLLIN, 0};
+        if (::poll(&p, 1, 1) <= 0) {
+            continue;
+        }
+        char buf[256];
+        ssize_t const n = ::read(fd, buf, sizeof(buf));
+        if (n <= 0) {
+            return ret;
+        }
+        ret.append(buf, static_cast<std::size_t>(n));
+    }
+    CHECK(!"connection was not closed");
+    return ret;
+}
+
+void add_options(cmdline::parser &p)
+{
+    p.add<std::string>("host", 0, "host name", true, "");
+    p.add<int>("port", 'p', "port number", false, 80);
+}
+
+/// @brief 驱动服务器直到收到 n 行回复
+std::string read_lines(cmdline::server &srv, int fd, std::size_t n)
+{
+    std::string ret;
+    for (int round = 0; round < 1000; round++) {
+        srv.run_once(0);
+        pollfd p{fd, POLLIN, 0};
+        if (::poll(&p, 1, 1) <= 0) {
+            continue;
+        }
+        char buf[256];
+        ssize_t const got = ::read(fd, buf, sizeof(buf));
+        CHECK(got > 0);
+        ret.append(buf, static_cast<std::size_t>(got));
+        std::size_t lines = 0;
+        for (char c : ret) {
+            lines += c == '\n' ? 1 : 0;
+        }
+        if (lines == n) {
+            return ret;
+        }
+    }
+    CHECK(!"no reply");
+    return ret;
+}
+
+/// @brief 一个会话的结果不受其他会话之后的命令影响
+void check_session_results(const std::string &path)
+{
+    std::vector<cmdline::server::session *> opened;
+    cmdline::parser restored;
+    add_options(restored);
+    cmdline::server srv(add_options, [&](cmdline::server::session &s, const cmdline::parser &p, bool ok) {
+        CHECK(s.ok() == ok);
+        CHECK(s.flags() == p.flags());
+        if (s.id() == 1) {
+            s.write((ok ? p.get<std::string>("host") : p.error()) + "\n");
+            return;
+        }
+        // 第二个会话的命令回复第一个会话最近一条命令的结果
+        const cmdline::server::session &first = *opened[0];
+        CHECK(restored.deserialize(first.result()));
+        s.write(restored.get<std::string>("host") + ":" + std::to_string(restored.get<int>("port")) + " " +
+                (first.ok() ? "ok" : restored.error()) + " " +
+                (first.flags().test(restored.flag("port")) ? "port" : "default") + "\n");
+    });
+    srv.set_open_handler([&](cmdline::server::session &s) { opened.push_back(&s); });
+    CHECK(srv.listen_unix(path));
+
+    int const a = connect_to(path);
+    int const b = connect_to(path);
+    CHECK(::write(a, "--host=a -p 1\n", 14) == 14);
+    CHECK(read_lines(srv, a, 1) == "a\n");
+    CHECK(opened.size() == 2);
+
+    CHECK(::write(b, "--host=b -p 2\n", 14) == 14);
+    CHECK(read_lines(srv, b, 1) == "a:1 ok port\n");
+    CHECK(::write(b, "-p x\n", 5) == 5);
+    CHECK(read_lines(srv, b, 1) == "a:1 ok port\n");
+
+    CHECK(::write(a, "-p 9\n", 5) == 5);
+    CHECK(read_lines(srv, a, 1) == "need option: --host\n");
+    CHECK(::write(b, "--host=c\n", 9) == 9);
+    CHECK(read_lines(srv, b, 1) == ":9 need option: --host port\n");
+
+    CHECK(::write(a, "--host=d\n", 9) == 9);
+    CHECK(read_lines(srv, a, 1) == "d\n");
+    CHECK(::write(b, "--host=e\n", 9) == 9);
+    CHECK(read_lines(srv, b, 1) == "d:80 ok default\n");
+    ::close(a);
+    ::close(b);
+}
+
+}  // namespace
+
+int main()
+{
+    std::string const path = "/tmp/cmdline_test_server." + std::to_string(::getpid());
+    cmdline::server srv([](cmdline::parser &p) { p.add<std::string>("host", 0, "host name", true, ""); },
+                        [](cmdline::server::session &s, const cmdline::parser &p, bool ok) {
+                            s.write((ok ? p.get<std::string>("host") : p.error()) + "\n");
+                        });
+    CHECK(srv.listen_unix(path));
+
+    // 最后一行没有换行，关闭写端后仍然要处理
+    int fd = connect_to(path);
+    std::string const commands = "--host=first\r\n--host=last";
+    CHECK(::write(fd, commands.data(), commands.size()) == static_cast<ssize_t>(commands.size()));
+    ::shutdown(fd, SHUT_WR);
+    CHECK(drain(srv, fd) == "first\nlast\n");
+    ::close(fd);
+
+    check_session_results(path + ".sessions");
+
+    // 描述符用尽：事先创建客户端套接字，占满描述符后再连接。先降低上限，少占一些描述符
+    rlimit lim{};
+    CHECK(::getrlimit(RLIMIT_NOFILE, &lim) == 0);
+    if (lim.rlim_cur > 256) {
+        lim.rlim_cur = 256;
+        CHECK(::setrlimit(RLIMIT_NOFILE, &lim) == 0);
+    }
+    int const pending = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    std::vector<int> filler;
+    for (int d; (d = ::dup(0)) >= 0;) {
+        filler.push_back(d);
+    }
+    CHECK(errno == EMFILE);
+    connect_to(path, pending);
+    // 服务器用预留的描述符取走连接并关闭，客户端看到连接关闭
+    CHECK(drain(srv, pending).empty());
+    for (int d : filler) {
+        ::close(d);
+    }
+    ::close(pending);
+
+    // 描述符恢复后照常服务
+    fd = connect_to(path);
+    CHECK(::write(fd, "--host=again\n", 13) == 13);
+    ::shutdown(fd, SHUT_WR);
+    CHECK(drain(srv, fd) == "again\n");
+    ::close(fd);
+    return 0;
+}
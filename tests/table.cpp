@@ -0,0 +1,134 @@
+/// @file table.cpp
+/// @brief 按描述表注册：默认值转换、重名和缩写重复，以及出错时解析器保持不变
+#include <cmdline/core.h>
+#include <cmdline/usage.h>
+
+#include <string>
+
+#include "check.h"
+
+namespace {
+
+const cmdline::option_def base_options[] = {
+    {"host", 0, "host name", cmdline::option_kind::string, true, nullptr},
+    {"port", 'p', "port number", cmdline::option_kind::integer, false, "80"},
+    {"ratio", 'r', "ratio", cmdline::option_kind::real, false, "0.5"},
+    {"size", 0, "size", cmdline::option_kind::int64, false, "8589934592"},
+    {"tls", 0, "use tls", cmdline::option_kind::boolean, false, "1"},
+    {"verbose", 'v', "verbose output", cmdline::option_kind::flag, false, nullptr},
+};
+
+/// @brief 添加失败后解析器与之前完全相同
+template <std::size_t N>
+void check_rejected(cmdline::parser &p, const cmdline::option_def (&table)[N])
+{
+    std::string const before = p.usage();
+    CHECK_THROWS(p.add_table(table));
+    CHECK(p.usage() == before);
+    CHECK(p.parse("prog --host=h -p 1 -v"));
+    CHECK(p.get<int>("port") == 1);
+    CHECK(!p.parse("prog --host=h --extra=1"));
+    CHECK(p.error() == "undefined option: --extra");
+}
+
+void check_defaults()
+{
+    cmdline::parser p;
+    p.add_table(base_options);
+    CHECK(p.parse("prog --host=h"));
+    CHECK(p.get<int>("port") == 80);
+    CHECK(p.get<double>("ratio") == 0.5);
+    CHECK(p.get<long long>("size") == 8589934592LL);
+    CHECK(p.get<bool>("tls"));
+    CHECK(!p.exist("verbose"));
+
+    CHECK(!p.parse("prog -p 1"));
+    CHECK(p.error() == "need option: --host");
+}
+
+void check_errors()
+{
+    cmdline::parser p;
+    p.set_program_name("prog");
+    p.add_table(base_options);
+
+    // 表内重名，与已有选项重名
+    const cmdline::option_def dup_in_table[] = {
+        {"extra", 0, "", cmdline::option_kind::flag, false, nullptr},
+        {"extra", 0, "", cmdline::option_kind::integer, false, nullptr},
+    };
+    check_rejected(p, dup_in_table);
+    const cmdline::option_def dup_existing[] = {
+        {"extra", 0, "", cmdline::option_kind::flag, false, nullptr},
+        {"port", 0, "", cmdline::option_kind::integer, false, nullptr},
+    };
+    check_rejected(p, dup_existing);
+
+    // 缩写在表内或与已有选项重复
+    const cmdline::option_def short_in_table[] = {
+        {"extra", 'x', "", cmdline::option_kind::flag, false, nullptr},
+        {"other", 'x', "", cmdline::option_kind::flag, false, nullptr},
+    };
+    check_rejected(p, short_in_table);
+    const cmdline::option_def short_existing[] = {
+        {"extra", 'v', "", cmdline::option_kind::flag, false, nullptr},
+    };
+    check_rejected(p, short_existing);
+
+    // 默认值的文本不能转换
+    const cmdline::option_def bad_int[] = {
+        {"extra", 0, "", cmdline::option_kind::integer, false, "8x"},
+    };
+    check_rejected(p, bad_int);
+    const cmdline::option_def bad_range[] = {
+        {"extra", 0, "", cmdline::option_kind::integer, false, "99999999999"},
+    };
+    check_rejected(p, bad_range);
+    const cmdline::option_def bad_real[] = {
+        {"extra", 0, "", cmdline::option_kind::real, false, "fast"},
+    };
+    check_rejected(p, bad_real);
+
+    // 名称为空
+    const cmdline::option_def empty_name[] = {
+        {"", 0, "", cmdline::option_kind::flag, false, nullptr},
+    };
+    check_rejected(p, empty_name);
+    const cmdline::option_def null_name[] = {
+        {nullptr, 0, "", cmdline::option_kind::flag, false, nullptr},
+    };
+    check_rejected(p, null_name);
+
+    // 之后仍然可以正常添加
+    const cmdline::option_def more[] = {
+        {"extra", 'x', nullptr, cmdline::option_kind::integer, false, "3"},
+    };
+    p.add_table(more);
+    CHECK(p.parse("prog --host=h -x 4"));
+    CHECK(p.get<int>("extra") == 4);
+}
+
+void check_add_short_names()
+{
+    // add() 接受重复的缩写，之后每次解析都失败；add_table() 在注册时就拒绝
+    cmdline::parser p;
+    p.add<int>("first", 'x', "", false, 0);
+    p.add<int>("second", 'x', "", false, 0);
+    CHECK(!p.parse("prog --first=1"));
+    CHECK(p.error() == "short option 'x' is ambiguous");
+
+    const cmdline::option_def table[] = {
+        {"third", 'x', "", cmdline::option_kind::flag, false, nullptr},
+    };
+    CHECK_THROWS(p.add_table(table));
+}
+
+}  // namespace
+
+int main()
+{
+    check_defaults();
+    check_errors();
+    check_add_short_names();
+    return 0;
+}
@@ -0,0 +1,76 @@
+/// @file tokenize.cpp
+/// @brief 分词失败时不能留下上一次解析的结果，以及只用 core.h 时的转换错误
+#include <cmdline/core.h>
+
+#include <string>
+#include <typeinfo>
+
+#include "check.h"
+
+namespace {
+
+void add_options(cmdline::parser &p)
+{
+    p.add<std::string>("command", 'c', "command", false, "help");
+    p.add("verbose", 'v', "verbose");
+    p.add_positional<std::string>("input", "input file", cmdline::arity::optional, "-");
+    p.add_positional<int>("ids", "record ids", cmdline::arity::variadic);
+}
+
+/// @brief 与从未解析过的 parser 相同，只有一个错误
+void check_clean(const cmdline::parser &p, const std::string &error)
+{
+    CHECK(p.error() == error);
+    CHECK(p.error_full() == error + "\n");
+    CHECK(!p.exist("command"));
+    CHECK(!p.exist("verbose"));
+    CHECK(p.get<std::string>("command") == "help");
+    CHECK(p.get_positional<std::string>("input") == "-");
+    CHECK(p.get_variadic<int>("ids").empty());
+    CHECK(p.rest().empty());
+}
+
+void run(cmdline::parser &p)
+{
+    add_options(p);
+    for (int i = 0; i < 2; i++) {
+        CHECK(p.parse("prog --command=bye -v in.txt 1 2 3"));
+        CHECK(p.get<std::string>("command") == "bye");
+        CHECK(p.get_variadic<int>("ids").size() == 3);
+
+        CHECK(!p.parse("prog --command=\"bye"));
+        check_clean(p, "quote is not closed");
+
+        CHECK(p.parse("prog --command=bye -v in.txt 1 2 3"));
+        CHECK(!p.parse("prog -v \\"));
+        check_clean(p, "unexpected occurrence of '\\' at end of string");
+
+        CHECK(p.parse("prog --command=bye -v in.txt 1 2 3"));
+        CHECK(!p.parse(0, nullptr));
+        check_clean(p, "argument number must be longer than 0");
+    }
+}
+
+}  // namespace
+
+int main()
+{
+    cmdline::parser plain;
+    run(plain);
+
+    // 第二轮的成功解析命中缓存，之后的失败同样要清除恢复出来的结果
+    cmdline::parser cached;
+    cached.enable_cache(8);
+    run(cached);
+    CHECK(cached.cache_hits() >= 3);
+
+    // 只包含 core.h 时转换失败同样抛出 std::bad_cast
+    bool thrown = false;
+    try {
+        cmdline::default_reader<int>()("12x");
+    } catch (const std::bad_cast & /*e*/) {
+        thrown = true;
+    }
+    CHECK(thrown);
+    return 0;
+}
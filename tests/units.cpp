@@ -0,0 +1,204 @@
+/// @file units.cpp
+/// @brief 带单位的数值：精确换算、溢出、连写的时长、带单位的上下界和 to_string 的往返
+#include <cmdline/core.h>
+#include <cmdline/units.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <typeinfo>
+
+#include "check.h"
+
+namespace {
+
+template <class T, class Units>
+bool read(const cmdline::unit_reader<T, Units> &r, const char *text, T &out)
+{
+    return r.read(text, text + std::strlen(text), out);
+}
+
+void check_bytes()
+{
+    auto const bytes = cmdline::byte_size();
+    std::uint64_t v = 0;
+    CHECK(read(bytes, "4096", v) && v == 4096);
+    CHECK(read(bytes, "1k", v) && v == 1000);
+    CHECK(read(bytes, "1KB", v) && v == 1000);
+    CHECK(read(bytes, "1KiB", v) && v == 1024);
+    CHECK(read(bytes, "1.5GB", v) && v == 1500000000);
+    CHECK(read(bytes, "1.5KiB", v) && v == 1536);
+    CHECK(read(bytes, "512 MiB", v) && v == 512ULL << 20);
+    CHECK(read(bytes, "15EiB", v) && v == 15ULL << 60);
+
+    // 溢出和不能精确表示的值不合法，out 不变
+    v = 7;
+    CHECK(!read(bytes, "16EiB", v));
+    CHECK(!read(bytes, "0.5B", v));
+    CHECK(!read(bytes, "1.0001KB", v));
+    CHECK(v == 7);
+    std::uint32_t small = 0;
+    CHECK(!read(cmdline::byte_size<std::uint32_t>(), "4GiB", small));
+    CHECK(read(cmdline::byte_size<std::uint32_t>(), "4095MiB", small) && small == 4095U << 20);
+
+    // 空白只能出现在数值和单位之间
+    const char *const bad[] = {"", "B", "1 ", " 1", "1MiB ", "1 MiB ", "1iB", "1Mi B", "-1", "1..5k", "1x"};
+    for (const char *text : bad) {
+        CHECK(!read(bytes, text, v));
+    }
+}
+
+void check_durations()
+{
+    using std::chrono::hours;
+    using std::chrono::milliseconds;
+    using std::chrono::minutes;
+    using std::chrono::nanoseconds;
+    using std::chrono::seconds;
+
+    milliseconds ms{0};
+    CHECK(read(cmdline::duration<milliseconds>(), "1500ms", ms) && ms.count() == 1500);
+    CHECK(read(cmdline::duration<milliseconds>(), "1.5s", ms) && ms.count() == 1500);
+    CHECK(read(cmdline::duration<milliseconds>(), "250", ms) && ms.count() == 250);
+    CHECK(!read(cmdline::duration<milliseconds>(), "1us", ms));
+
+    seconds s{0};
+    CHECK(!read(cmdline::duration<seconds>(), "1500ms", s));
+    CHECK(!read(cmdline::duration<seconds>(), "1.5s", s));
+    CHECK(read(cmdline::duration<seconds>(), "1h30m", s) && s.count() == 5400);
+    CHECK(read(cmdline::duration<seconds>(), "1h30min15s", s) && s.count() == 5415);
+    CHECK(read(cmdline::duration<seconds>(), "2d", s) && s.count() == 172800);
+    // 没有单位的数只能单独出现
+    CHECK(!read(cmdline::duration<seconds>(), "1h30", s));
+    CHECK(!read(cmdline::duration<seconds>(), "", s));
+    CHECK(!read(cmdline::duration<seconds>(), "1 s", s));
+    CHECK(!read(cmdline::duration<seconds>(), "1s ", s));
+    CHECK(!read(cmdline::duration<seconds>(), "-1s", s));
+
+    minutes m{0};
+    CHECK(read(cmdline::duration<minutes>(), "1h30m", m) && m.count() == 90);
+    hours h{0};
+    CHECK(read(cmdline::duration<hours>(), "2d", h) && h.count() == 48);
+
+    nanoseconds ns{0};
+    CHECK(read(cmdline::duration<nanoseconds>(), "1\xC2\xB5s", ns) && ns.count() == 1000);
+    CHECK(read(cmdline::duration<nanoseconds>(), "106751d", ns));
+    CHECK(!read(cmdline::duration<nanoseconds>(), "106752d", ns));
+
+    std::chrono::duration<double> fs{0};
+    CHECK(read(cmdline::duration<std::chrono::duration<double>>(), "1.5s", fs) && fs.count() == 1.5);
+    CHECK(read(cmdline::duration<std::chrono::duration<double>>(), "1500ms", fs) && fs.count() == 1.5);
+}
+
+void check_rates()
+{
+    double r = 0;
+    CHECK(read(cmdline::rate(), "10k/s", r) && r == 10000);
+    CHECK(read(cmdline::rate(), "600/min", r) && r == 10);
+    CHECK(read(cmdline::rate(), "250", r) && r == 250);
+    CHECK(read(cmdline::rate(), "1/ms", r) && r == 1000);
+    CHECK(!read(cmdline::rate(), "10k/", r));
+    CHECK(!read(cmdline::rate(), "10k/s ", r));
+    CHECK(!read(cmdline::rate(), "10x/s", r));
+
+    std::uint64_t n = 0;
+    CHECK(read(cmdline::rate<std::uint64_t>(), "7200/h", n) && n == 2);
+    CHECK(!read(cmdline::rate<std::uint64_t>(), "5/h", n));
+    CHECK(!read(cmdline::rate<std::uint64_t>(), "1.5/s", n));
+}
+
+void check_bounds()
+{
+    using std::chrono::milliseconds;
+
+    auto const cache = cmdline::byte_size("1MiB", "64GiB");
+    std::uint64_t v = 0;
+    CHECK(read(cache, "1MiB", v));
+    CHECK(read(cache, "64GiB", v));
+    CHECK(!read(cache, "512KiB", v));
+    CHECK(!read(cache, "65GiB", v));
+
+    auto const timeout = cmdline::duration<milliseconds>("1ms", "30s");
+    milliseconds ms{0};
+    CHECK(read(timeout, "30s", ms) && ms.count() == 30000);
+    CHECK(!read(timeout, "31s", ms));
+    CHECK(!read(timeout, "0ms", ms));
+
+    double r = 0;
+    CHECK(read(cmdline::rate("1/s", "10k/s"), "10k/s", r));
+    CHECK(!read(cmdline::rate("1/s", "10k/s"), "20k/s", r));
+
+    // 上下界的文本不合法时注册阶段就报错
+    CHECK_THROWS(cmdline::byte_size("1MiB", "64GiB "));
+    CHECK_THROWS(cmdline::duration<milliseconds>("1us", "30s"));
+    CHECK_THROWS(cmdline::rate("1/s", "fast"));
+
+    // 直接调用 reader 时失败抛出 std::bad_cast
+    bool thrown = false;
+    try {
+        cache("1KiB");
+    } catch (const std::bad_cast & /*e*/) {
+        thrown = true;
+    }
+    CHECK(thrown);
+
+    // 在解析器中与其他 reader 一样报告错误
+    cmdline::parser p;
+    p.add<std::uint64_t>("cache", 0, "cache size", false, 64 << 20, cmdline::byte_size("1MiB", "64GiB"));
+    p.add<milliseconds>("timeout", 't', "timeout", false, milliseconds(250),
+                        cmdline::range<milliseconds>(milliseconds(1), std::chrono::seconds(30)));
+    CHECK(p.parse("prog --cache=2GiB -t 1.5s"));
+    CHECK(p.get<std::uint64_t>("cache") == 2ULL << 30);
+    CHECK(p.get<milliseconds>("timeout").count() == 1500);
+    CHECK(!p.parse("prog --cache=512KiB"));
+    CHECK(p.error() == "option value is invalid: --cache=512KiB");
+    CHECK(!p.parse("prog -t 1m"));
+    CHECK(p.error() == "option value is invalid: --timeout=1m");
+}
+
+template <class D>
+void check_round_trip(const D &d, const std::string &text)
+{
+    std::string const s = cmdline::detail::converter<D>::to_string(d);
+    CHECK(s == text);
+    D back{};
+    CHECK(cmdline::detail::converter<D>::from_string(s.data(), s.data() + s.size(), back));
+    CHECK(back == d);
+}
+
+void check_to_string()
+{
+    using std::chrono::hours;
+    using std::chrono::milliseconds;
+    using std::chrono::nanoseconds;
+    using std::chrono::seconds;
+
+    check_round_trip(seconds(0), "0s");
+    check_round_trip(seconds(5400), "90min");
+    check_round_trip(seconds(59), "59s");
+    check_round_trip(seconds(90061), "90061s");
+    check_round_trip(hours(48), "2d");
+    check_round_trip(milliseconds(1500), "1500ms");
+    check_round_trip(milliseconds(250), "250ms");
+    check_round_trip(nanoseconds(3000), "3us");
+    check_round_trip(std::chrono::duration<double>(1.5), "1.5s");
+    for (long long n = 1; n < 200000; n = n * 3 + 1) {
+        std::string const s = cmdline::detail::converter<milliseconds>::to_string(milliseconds(n));
+        milliseconds back{0};
+        CHECK(cmdline::detail::converter<milliseconds>::from_string(s.data(), s.data() + s.size(), back));
+        CHECK(back.count() == n);
+    }
+}
+
+}  // namespace
+
+int main()
+{
+    check_bytes();
+    check_durations();
+    check_rates();
+    check_bounds();
+    check_to_string();
+    return 0;
+}
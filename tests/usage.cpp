@@ -0,0 +1,54 @@
+/// @file usage.cpp
+/// @brief 帮助信息中的默认值，以及移动进选项的 reader
+#include <cmdline/core.h>
+#include <cmdline/usage.h>
+
+#include <memory>
+#include <string>
+
+#include "check.h"
+
+namespace {
+
+/// @brief 只能移动的 reader
+struct scaled_reader
+{
+    std::unique_ptr<int> factor;
+
+    int operator()(const std::string &s) const { return std::stoi(s) * *factor; }
+};
+
+}  // namespace
+
+int main()
+{
+    cmdline::parser p;
+    p.add<std::string>("short", 0, "short default", false, "abc");
+    p.add<std::string>("long", 0, "long default", false, std::string(8 << 20, 'x'));
+    p.add<int>("num", 0, "number", false, 7);
+    p.add_map<int>("set", 's', "tunables", scaled_reader{std::unique_ptr<int>(new int(10))});
+
+    // 默认完整显示，与之前的版本相同
+    std::string usage = p.usage();
+    CHECK(usage.find("[=abc]") != std::string::npos);
+    CHECK(usage.find("[=" + std::string(8 << 20, 'x') + "]") != std::string::npos);
+    CHECK(usage.find("[=7]") != std::string::npos);
+
+    // 限制宽度后截断，短的默认值不受影响
+    p.set_default_width(64);
+    usage = p.usage();
+    CHECK(usage.find("[=abc]") != std::string::npos);
+    CHECK(usage.find("[=" + std::string(64, 'x') + "...]") != std::string::npos);
+    CHECK(usage.size() < 4096);
+    CHECK(usage.find("[=7]") != std::string::npos);
+    p.set_default_width(2);
+    CHECK(p.usage().find("[=ab...]") != std::string::npos);
+    CHECK(p.usage().find("[=7]") != std::string::npos);
+
+    // 默认值本身不截断
+    CHECK(p.get<std::string>("long").size() == std::size_t(8) << 20);
+
+    CHECK(p.parse("prog -s a=1,b=2"));
+    CHECK(p.get_map<int>("set").at("b") == 20);
+    return 0;
+}